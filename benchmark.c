@@ -0,0 +1,247 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+#include "src/gate.h"
+#include "src/sequential.h"
+#include "src/timing.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Total number of gate inputs evaluated per measurement
+#define WIDE_GATE_INPUTS 20000000
+
+// Size of the random circuit simulated by the timing benchmark
+#define TIMING_SIGNALS 64
+#define TIMING_GATES 5000
+#define TIMING_RUNS 20000
+
+// Width of the counter and number of cycles of the sequential benchmark
+#define COUNTER_BITS 16
+#define COUNTER_CYCLES 2000000
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+// Expected output of a gate, folded one input at a time
+static bool expected(gate_kind_t kind, bool const *s, unsigned n) {
+    bool res = kind == AND || kind == NAND;
+    for (unsigned i = 0; i < n; ++i) {
+        if (kind == AND || kind == NAND) {
+            res = res && s[i];
+        } else if (kind == OR || kind == NOR) {
+            res = res || s[i];
+        } else {
+            res = res != s[i];
+        }
+    }
+
+    return kind == NAND || kind == NOR || kind == XNOR ? !res : res;
+}
+
+// Measures `gate_evaluate` on a single gate whose `n` inputs are all connected to signals
+static void bench_wide_gate(gate_kind_t kind, char const *name, unsigned n) {
+    bool *s = malloc(n * sizeof(bool));
+    gate_t *g = gate_new(kind, n);
+    assert(s != NULL && g != NULL);
+
+    // Mostly ones, so that AND gates do not settle on the first input
+    for (unsigned i = 0; i < n; ++i) {
+        s[i] = rand() % 64 != 0;
+        assert(gate_connect_signal(&s[i], g, i) == 0);
+    }
+
+    unsigned rounds = WIDE_GATE_INPUTS / n + 1;
+    bool b = false;
+    unsigned ones = 0;
+
+    double start = now();
+    for (unsigned r = 0; r < rounds; ++r) {
+        assert(gate_evaluate(&g, &b, 1) == 1);
+        ones += b;
+    }
+    double elapsed = now() - start;
+
+    assert(b == expected(kind, s, n));
+    assert(ones == 0 || ones == rounds);
+
+    printf("%-4s fan-in %6u: %8.3f ns/input, %10.1f ns/gate\n", name, n,
+           elapsed * 1e9 / ((double) rounds * n), elapsed * 1e9 / rounds);
+
+    gate_delete(g);
+    free(s);
+}
+
+// Checks that inputs of a gate changing at the same time do not produce a zero-width pulse
+static void check_timing_same_time(void) {
+    bool a = false, b = false;
+    gate_t *x = gate_new(XOR, 2);
+    gate_t *y = gate_new(AND, 1);
+    assert(x != NULL && y != NULL);
+    assert(gate_connect_signal(&a, x, 0) == 0);
+    assert(gate_connect_signal(&b, x, 1) == 0);
+    assert(gate_connect_gate(x, y, 0) == 0);
+
+    gate_timing_t *t = gate_timing_new(&y, 1, NULL);
+    assert(t != NULL);
+
+    gate_stimulus_t const s[] = {{.signal = &a, .value = true, .time = 5}, {.signal = &b, .value = true, .time = 5}};
+    assert(gate_timing_run(t, s, 2) == 5);
+    assert(gate_timing_value(t, x) == 0 && gate_timing_value(t, y) == 0);
+    assert(gate_timing_glitches(t, x) == 0 && gate_timing_glitches(t, y) == 0);
+    assert(gate_timing_settle_time(t, x) == 0 && gate_timing_events(t) == 0);
+
+    gate_timing_delete(t);
+    gate_delete(y);
+    gate_delete(x);
+}
+
+// Measures the event throughput of `gate_timing_run` on a random layered circuit
+static void bench_timing(void) {
+    static unsigned const delay[] = {2, 2, 1, 1, 3, 3};
+    bool s[TIMING_SIGNALS] = {false};
+    gate_t **g = malloc(TIMING_GATES * sizeof(gate_t *));
+    assert(g != NULL);
+
+    // Every gate reads from the signals or from the 100 gates created before it.
+    for (unsigned i = 0; i < TIMING_GATES; ++i) {
+        unsigned n = 1 + rand() % 4;
+        g[i] = gate_new((gate_kind_t) (rand() % 6), n);
+        assert(g[i] != NULL);
+
+        for (unsigned k = 0; k < n; ++k) {
+            if (i > 0 && rand() % 4 != 0) {
+                unsigned back = 1 + rand() % (i < 100 ? i : 100);
+                assert(gate_connect_gate(g[i - back], g[i], k) == 0);
+            } else {
+                assert(gate_connect_signal(&s[rand() % TIMING_SIGNALS], g[i], k) == 0);
+            }
+        }
+    }
+
+    gate_t *roots[64];
+    for (unsigned j = 0; j < 64; ++j) {
+        roots[j] = g[TIMING_GATES - 1 - j];
+    }
+
+    gate_timing_t *t = gate_timing_new(roots, 64, delay);
+    assert(t != NULL);
+
+    uint64_t time = 0;
+    double start = now();
+    for (unsigned r = 0; r < TIMING_RUNS; ++r) {
+        unsigned i = rand() % TIMING_SIGNALS;
+        s[i] = !s[i];
+        gate_stimulus_t stimulus = {.signal = &s[i], .value = s[i], .time = time};
+        ssize_t end = gate_timing_run(t, &stimulus, 1);
+        assert(end >= 0);
+        time = (uint64_t) end;
+    }
+    double elapsed = now() - start;
+
+    bool out[64];
+    assert(gate_evaluate(roots, out, 64) >= 0);
+    for (unsigned j = 0; j < 64; ++j) {
+        assert(gate_timing_value(t, roots[j]) == out[j]);
+    }
+
+    ssize_t events = gate_timing_events(t);
+    printf("timing %u gates: %zd events, %8.2f M events/s\n", TIMING_GATES, events,
+           (double) events / elapsed * 1e-6);
+
+    gate_timing_delete(t);
+    for (unsigned i = 0; i < TIMING_GATES; ++i) {
+        gate_delete(g[i]);
+    }
+    free(g);
+}
+
+// Measures `gate_seq_step` on a counter with an enable input, 64 runs at once
+static void bench_sequential(void) {
+    bool en = false;
+    gate_reg_t *r[COUNTER_BITS];
+    gate_t *carry[COUNTER_BITS];
+    gate_t *sum[COUNTER_BITS];
+
+    // Bit i toggles when the counter is enabled and all lower bits are set.
+    for (unsigned i = 0; i < COUNTER_BITS; ++i) {
+        r[i] = gate_reg_new(false);
+        carry[i] = gate_new(AND, i + 1);
+        sum[i] = gate_new(XOR, 2);
+        assert(r[i] != NULL && carry[i] != NULL && sum[i] != NULL);
+
+        assert(gate_connect_signal(&en, carry[i], 0) == 0);
+        for (unsigned j = 0; j < i; ++j) {
+            assert(gate_connect_signal(gate_reg_output(r[j]), carry[i], j + 1) == 0);
+        }
+        assert(gate_connect_signal(gate_reg_output(r[i]), sum[i], 0) == 0);
+        assert(gate_connect_gate(carry[i], sum[i], 1) == 0);
+        assert(gate_reg_connect_gate(sum[i], r[i]) == 0);
+    }
+
+    bool const *in[] = {&en};
+    gate_seq_t *q = gate_seq_new(r, COUNTER_BITS, NULL, 0, in, 1, 64);
+    uint64_t *enable = malloc(COUNTER_CYCLES * sizeof(uint64_t));
+    assert(q != NULL && enable != NULL);
+
+    // Run j is enabled in every cycle whose number has bit j % 8 set.
+    uint64_t expected[64] = {0};
+    for (unsigned c = 0; c < COUNTER_CYCLES; ++c) {
+        enable[c] = 0;
+        for (unsigned j = 0; j < 64; ++j) {
+            if (c >> (j % 8) & 1) {
+                enable[c] |= UINT64_C(1) << j;
+                expected[j]++;
+            }
+        }
+    }
+
+    double start = now();
+    assert(gate_seq_step(q, enable, NULL, COUNTER_CYCLES) == 0);
+    double elapsed = now() - start;
+
+    for (unsigned i = 0; i < COUNTER_BITS; ++i) {
+        uint64_t bits;
+        assert(gate_seq_get_state(q, i, &bits) == 0);
+        for (unsigned j = 0; j < 64; ++j) {
+            assert((bits >> j & 1) == (expected[j] >> i & 1));
+        }
+    }
+
+    printf("sequential %u-bit counter: %8.2f M cycles/s (64 runs each)\n", COUNTER_BITS,
+           COUNTER_CYCLES / elapsed * 1e-6);
+
+    gate_seq_delete(q);
+    free(enable);
+    for (unsigned i = 0; i < COUNTER_BITS; ++i) {
+        gate_delete(sum[i]);
+        gate_delete(carry[i]);
+        gate_reg_delete(r[i]);
+    }
+}
+
+int main(void) {
+    static unsigned const fan_in[] = {2, 8, 32, 64, 256, 1024, 4096, 16384, 100000};
+    static gate_kind_t const kinds[] = {AND, OR, XOR};
+    static char const *const names[] = {"AND", "OR", "XOR"};
+
+    srand(1);
+
+    for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); ++k) {
+        for (size_t i = 0; i < sizeof(fan_in) / sizeof(fan_in[0]); ++i) {
+            bench_wide_gate(kinds[k], names[k], fan_in[i]);
+        }
+    }
+
+    check_timing_same_time();
+    bench_timing();
+    bench_sequential();
+
+    return 0;
+}
@@ -1,22 +1,17 @@
 #include <errno.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <sys/types.h>
 
 #include "gate.h"
+#include "gate_internal.h"
 #include "vector.h"
 
-// Enum for NAND gate states
-typedef enum state {
-    UNVISITED, // Unvisited gate
-    VISITED,   // Visited gate, but not fully calculated
-    CALCULATED // Visited and fully calculated gate
-} state;
-
-typedef enum error_code {
-    FAILED = -1,
-    SUCCESS = 0,
-} error_code;
+// Gates with at least this many inputs are evaluated on packed words of input bits
+#define WIDE_GATE_MIN_FAN_IN 64
+// Number of 64-bit words of input bits gathered before they are reduced
+#define WIDE_CHUNK_WORDS 64
 
 // Auxiliary structure for passing an error code
 typedef struct res_with_code {
@@ -24,15 +19,6 @@ typedef struct res_with_code {
     int code;
 } res_with_code;
 
-struct gate {
-    vector_in *in;
-    vector_out *out;
-    state state;
-    bool res;
-    unsigned path_len;
-    gate_kind_t kind;
-};
-
 static int vector_out_delete_element(vector_out *vec, element_out *el) {
     size_t last_idx = vector_out_size(vec) - 1;
 
@@ -79,6 +65,7 @@ gate_t *gate_new(gate_kind_t kind, unsigned n) {
     g->state = UNVISITED;
     g->path_len = 1;
     g->kind = kind;
+    g->ports = NULL;
 
     return g;
 }
@@ -204,9 +191,52 @@ void gate_delete(gate_t *g) {
 
     vector_out_free(out);
 
+    // Ports of instances and registers bound to the gate become unconnected.
+    if (g->ports != NULL) {
+        for (size_t i = 0; i < g->ports->size; ++i) {
+            *g->ports->data[i] = (element_in){.connection_type = SIGNAL, .pointer = NULL, .origin = NULL};
+        }
+        free(g->ports);
+    }
+
     free(g);
 }
 
+int gate_port_bind(element_in *port, gate_t *g) {
+    gate_ports *ports = g->ports;
+    if (ports == NULL || ports->size == ports->cap) {
+        size_t cap = ports == NULL ? 4 : ports->cap * 2;
+        ports = realloc(ports, sizeof(gate_ports) + cap * sizeof(element_in *));
+        if (ports == NULL) {
+            errno = ENOMEM;
+            return FAILED;
+        }
+        if (g->ports == NULL) {
+            ports->size = 0;
+        }
+        ports->cap = cap;
+        g->ports = ports;
+    }
+
+    gate_port_unbind(port);
+    *port = (element_in){.connection_type = GATE, .pointer = g, .port = ports->size};
+    ports->data[ports->size++] = port;
+
+    return SUCCESS;
+}
+
+void gate_port_unbind(element_in *port) {
+    if (port->connection_type == GATE && port->pointer != NULL) {
+        // The last port of the gate takes the place of the removed one.
+        gate_ports *ports = ((gate_t *) port->pointer)->ports;
+        element_in *last = ports->data[--ports->size];
+        ports->data[port->port] = last;
+        last->port = port->port;
+    }
+
+    *port = (element_in){.connection_type = SIGNAL, .pointer = NULL, .origin = NULL};
+}
+
 // A function that recursively restores the state of the gate to its state before the nand_evaluate function was called
 static void nand_clean_recursive(gate_t *g) {
     if (g == NULL) return;
@@ -214,8 +244,12 @@ static void nand_clean_recursive(gate_t *g) {
     if (g->state == UNVISITED) return;
 
     g->state = UNVISITED;
-    for (size_t i = 0; i < vector_in_size(g->in); ++i) {
-        element_in *in_value = get_element_in_at_index(g->in, i);
+
+    // The inputs are scanned directly, as this pass runs over every input of wide gates too.
+    element_in **in = g->in->data;
+    size_t n = vector_in_capacity(g->in);
+    for (size_t i = 0; i < n; ++i) {
+        element_in *in_value = in[i];
         if (in_value != NULL && in_value->connection_type == GATE) {
             gate_t *g_in = (gate_t *) in_value->pointer;
             if (g_in->state != UNVISITED) nand_clean_recursive(g_in);
@@ -244,7 +278,7 @@ static int calculate_result(bool *res_value, bool signal, gate_kind_t kind) {
             break;
         case XOR:
         case XNOR:
-            *res_value *= signal;
+            *res_value ^= signal;
             break;
         default:
             return -1;
@@ -253,6 +287,105 @@ static int calculate_result(bool *res_value, bool signal, gate_kind_t kind) {
     return 0;
 }
 
+// Reduces `n` words of packed input bits into the accumulator `acc`. The loops are kept branch-free,
+// so that they are vectorized in the Release build.
+static uint64_t reduce_words(uint64_t const *words, size_t n, uint64_t acc, gate_kind_t kind) {
+    switch (kind) {
+        case AND:
+        case NAND:
+            for (size_t i = 0; i < n; ++i) acc &= words[i];
+            break;
+        case OR:
+        case NOR:
+            for (size_t i = 0; i < n; ++i) acc |= words[i];
+            break;
+        default:
+            for (size_t i = 0; i < n; ++i) acc ^= words[i];
+            break;
+    }
+
+    return acc;
+}
+
+static res_with_code nand_evaluate_recursive(gate_t *g);
+
+// A function that calculates the value of a single input of gate g, updating its critical path
+static res_with_code input_value(gate_t *g, element_in const *in_value) {
+    if (in_value->connection_type == SIGNAL) {
+        return (res_with_code){.res = *(bool const *) in_value->pointer, .code = SUCCESS};
+    }
+
+    gate_t *g_in = in_value->pointer;
+    if (g == g_in) {
+        return (res_with_code){false, FAILED};
+    }
+
+    res_with_code res = nand_evaluate_recursive(g_in);
+    if (res.code == SUCCESS) {
+        g->path_len = max(g->path_len, g_in->path_len);
+    }
+
+    return res;
+}
+
+// A function that calculates the result of a gate with a high fan-in: the input bits are gathered into
+// packed words, which are then reduced with word-wide AND/OR and a popcount parity for XOR/XNOR
+static res_with_code nand_evaluate_wide(gate_t *g) {
+    if (g->kind != AND && g->kind != NAND && g->kind != OR && g->kind != NOR && g->kind != XOR && g->kind != XNOR) {
+        return (res_with_code){false, FAILED};
+    }
+
+    uint64_t chunk[WIDE_CHUNK_WORDS];
+    bool is_and = g->kind == AND || g->kind == NAND;
+    uint64_t acc = is_and ? ~UINT64_C(0) : 0;
+    size_t n = vector_in_size(g->in);
+
+    for (size_t base = 0; base < n; base += WIDE_CHUNK_WORDS * 64) {
+        size_t count = n - base < WIDE_CHUNK_WORDS * 64 ? n - base : WIDE_CHUNK_WORDS * 64;
+        size_t words = (count + 63) / 64;
+
+        for (size_t w = 0; w < words; ++w) {
+            size_t bits = count - w * 64 < 64 ? count - w * 64 : 64;
+            element_in **in = g->in->data + base + w * 64;
+            uint64_t word = 0;
+
+            for (size_t i = 0; i < bits; ++i) {
+                uint64_t bit;
+                if (in[i]->connection_type == SIGNAL) {
+                    // Signals are read directly, as they make up most of the inputs of wide gates.
+                    bit = *(bool const *) in[i]->pointer;
+                } else {
+                    res_with_code res = input_value(g, in[i]);
+                    if (res.code != SUCCESS) {
+                        return res;
+                    }
+                    bit = res.res;
+                }
+                word |= bit << i;
+            }
+
+            chunk[w] = word;
+        }
+
+        if (is_and && count % 64 != 0) {
+            chunk[words - 1] |= ~UINT64_C(0) << (count % 64); // Padding with ones, which do not change the AND.
+        }
+
+        acc = reduce_words(chunk, words, acc, g->kind);
+    }
+
+    switch (g->kind) {
+        case AND:
+        case NAND:
+            return (res_with_code){.res = acc == ~UINT64_C(0), .code = SUCCESS};
+        case OR:
+        case NOR:
+            return (res_with_code){.res = acc != 0, .code = SUCCESS};
+        default:
+            return (res_with_code){.res = __builtin_popcountll(acc) & 1, .code = SUCCESS};
+    }
+}
+
 // A function that recursively traverses the gates connected to gate g, calculating the boolean signal and
 // the maximum critical path for the given gate
 static res_with_code nand_evaluate_recursive(gate_t *g) {
@@ -269,34 +402,29 @@ static res_with_code nand_evaluate_recursive(gate_t *g) {
         return (res_with_code){.res = false, .code = FAILED};
     }
 
-    g->state = VISITED;
-
-    g->path_len = 0;
-
     bool res_value = true;
     if (g->kind == OR || g->kind == NOR || g->kind == XNOR || g->kind == XOR) {
         res_value = false; // Only for OR and NOR gates, the initial result must be false.
     }
 
-    for (size_t i = 0; i < vector_in_size(g->in); ++i) {
-        element_in *in_value = get_element_in_at_index(g->in, i);
-        if (in_value == NULL) {
-            continue;
-        }
+    g->state = VISITED;
 
-        if (in_value->connection_type == SIGNAL) {
-            bool const *signal = in_value->pointer;
-            const int status_code = calculate_result(&res_value, *signal, g->kind);
-            if (status_code == -1) {
-                return (res_with_code){false, FAILED};
-            }
-        } else {
-            gate_t *g_in = in_value->pointer;
-            if (g == g_in) {
-                return (res_with_code){false, FAILED};
+    g->path_len = 0;
+
+    if (vector_in_size(g->in) >= WIDE_GATE_MIN_FAN_IN) {
+        res_with_code res = nand_evaluate_wide(g);
+        if (res.code != SUCCESS) {
+            return res;
+        }
+        res_value = res.res;
+    } else {
+        for (size_t i = 0; i < vector_in_size(g->in); ++i) {
+            element_in *in_value = get_element_in_at_index(g->in, i);
+            if (in_value == NULL) {
+                continue;
             }
 
-            res_with_code res = nand_evaluate_recursive(g_in);
+            res_with_code res = input_value(g, in_value);
             if (res.code != SUCCESS) {
                 return res;
             }
@@ -305,8 +433,6 @@ static res_with_code nand_evaluate_recursive(gate_t *g) {
             if (status_code == -1) {
                 return (res_with_code){false, FAILED};
             }
-
-            g->path_len = max(g->path_len, g_in->path_len);
         }
     }
 
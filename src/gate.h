@@ -89,6 +89,7 @@ ssize_t gate_evaluate(gate_t **g, bool *s, size_t m);
  * @brief Returns the fan-out of the specified gate.
  *
  * Calculates the number of inputs in other gates connected to the output of the given gate.
+ * Input ports of module instances and inputs of registers bound to the gate are not counted.
  *
  * @param g Pointer to the gate.
  * @return
@@ -0,0 +1,51 @@
+#ifndef GATE_INTERNAL_H
+#define GATE_INTERNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gate.h"
+#include "vector.h"
+
+// Enum for NAND gate states
+typedef enum state {
+    UNVISITED, // Unvisited gate
+    VISITED,   // Visited gate, but not fully calculated
+    CALCULATED // Visited and fully calculated gate
+} state;
+
+typedef enum error_code {
+    FAILED = -1,
+    SUCCESS = 0,
+} error_code;
+
+// Ports of module instances and registers bound to the output of a gate
+typedef struct gate_ports {
+    size_t size;
+    size_t cap;
+    element_in *data[];
+} gate_ports;
+
+struct gate {
+    vector_in *in;
+    vector_out *out;
+    gate_ports *ports; // Allocated when the first port is bound to the gate.
+    state state;
+    gate_kind_t kind;
+    // Scratch value of the current traversal, valid only while the gate is CALCULATED: the critical path
+    // length during `gate_evaluate`, the slot assigned by the netlist compiler during compilation.
+    union {
+        unsigned path_len;
+        unsigned idx;
+    };
+    bool res;
+};
+
+// Binds a port of an instance or a register to the output of `g`, releasing its previous binding.
+// The port is cleared (unconnected) when `g` is deleted. Fails with `ENOMEM`, leaving the port unchanged.
+int gate_port_bind(element_in *port, gate_t *g);
+
+// Makes a port unconnected, releasing its binding to a gate if it has one.
+void gate_port_unbind(element_in *port);
+
+#endif
@@ -0,0 +1,416 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "gate_internal.h"
+#include "module.h"
+#include "netlist.h"
+#include "vector.h"
+
+struct gate_module {
+    netlist nl; // The compiled body, shared by all instances
+};
+
+struct gate_instance {
+    gate_module_t const *mod;
+    element_in *in; // Port bindings; `pointer` is NULL for an unconnected port.
+    bool *out;
+    state state;
+    size_t idx; // Slot of the first output while the instance is compiled into a module.
+};
+
+// Context of a single `gate_module_new` call
+typedef struct module_ctx {
+    netlist_builder b;
+    signal_table ports;
+    gate_instance_t **sub; // Sub-instances sorted by the address of their outputs
+    size_t k;
+} module_ctx;
+
+static int instance_cmp(void const *a, void const *b) {
+    uintptr_t x = (uintptr_t) (*(gate_instance_t *const *) a)->out;
+    uintptr_t y = (uintptr_t) (*(gate_instance_t *const *) b)->out;
+    return (x > y) - (x < y);
+}
+
+// Position of the signal `s` among the outputs of `inst`. The addresses are compared as integers, since `s` may
+// point into another object.
+static size_t output_index(gate_instance_t const *inst, bool const *s) {
+    return ((uintptr_t) s - (uintptr_t) inst->out) / sizeof(bool);
+}
+
+// Finds the sub-instance whose outputs contain the signal `s`
+static gate_instance_t *find_instance(module_ctx const *c, bool const *s) {
+    size_t lo = 0;
+    size_t hi = c->k;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((uintptr_t) c->sub[mid]->out <= (uintptr_t) s) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo == 0) {
+        return NULL;
+    }
+
+    gate_instance_t *inst = c->sub[lo - 1];
+    if (output_index(inst, s) >= inst->mod->nl.n_outputs) {
+        return NULL;
+    }
+
+    return inst;
+}
+
+static ssize_t module_resolve(void *ctx, bool const *s);
+
+// Compiles a sub-instance into a call of its module's body, returning the slot of its first output
+static ssize_t module_add_instance(module_ctx *c, gate_instance_t *inst) {
+    if (inst->state == CALCULATED) {
+        return (ssize_t) inst->idx;
+    }
+
+    if (inst->state == VISITED) {
+        // We have found a cycle
+        errno = ECANCELED;
+        return FAILED;
+    }
+
+    size_t n = inst->mod->nl.n_inputs;
+    size_t *srcs = NULL;
+    if (n > 0) {
+        srcs = malloc(n * sizeof(size_t));
+        if (srcs == NULL) {
+            errno = ENOMEM;
+            return FAILED;
+        }
+    }
+
+    inst->state = VISITED;
+
+    for (size_t i = 0; i < n; ++i) {
+        element_in const *port = &inst->in[i];
+        ssize_t slot;
+        if (port->pointer == NULL) {
+            errno = ECANCELED;
+            slot = FAILED;
+        } else if (port->connection_type == GATE) {
+            slot = netlist_builder_add(&c->b, port->pointer);
+        } else {
+            slot = module_resolve(c, port->pointer);
+        }
+
+        if (slot < 0) {
+            inst->state = UNVISITED;
+            free(srcs);
+            return FAILED;
+        }
+        srcs[i] = (size_t) slot;
+    }
+
+    ssize_t dst = netlist_builder_call(&c->b, &inst->mod->nl, srcs);
+    free(srcs);
+    if (dst < 0) {
+        inst->state = UNVISITED;
+        return FAILED;
+    }
+
+    inst->idx = (size_t) dst;
+    inst->state = CALCULATED;
+    return dst;
+}
+
+static ssize_t module_resolve(void *ctx, bool const *s) {
+    module_ctx *c = ctx;
+
+    ssize_t col = signal_table_find(&c->ports, s);
+    if (col >= 0) {
+        return col;
+    }
+
+    gate_instance_t *inst = find_instance(c, s);
+    if (inst == NULL) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    ssize_t dst = module_add_instance(c, inst);
+    if (dst < 0) {
+        return FAILED;
+    }
+
+    return dst + (ssize_t) output_index(inst, s);
+}
+
+gate_module_t *gate_module_new(gate_t **g, size_t m, bool const **s, size_t n, gate_instance_t **sub, size_t k) {
+    if (g == NULL || m == 0 || (s == NULL && n > 0) || (sub == NULL && k > 0)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    for (size_t i = 0; i < m; ++i) {
+        if (g[i] == NULL) {
+            errno = EINVAL;
+            return NULL;
+        }
+    }
+
+    module_ctx c = {.k = k};
+    if (signal_table_init(&c.ports, s, n) != SUCCESS) {
+        return NULL;
+    }
+
+    gate_module_t *mod = malloc(sizeof(gate_module_t));
+    size_t *outputs = malloc(m * sizeof(size_t));
+    if (k > 0) {
+        c.sub = malloc(k * sizeof(gate_instance_t *));
+    }
+    if (mod == NULL || outputs == NULL || (k > 0 && c.sub == NULL)) {
+        signal_table_free(&c.ports);
+        free(mod);
+        free(outputs);
+        free(c.sub);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    int code = SUCCESS;
+    for (size_t i = 0; i < k; ++i) {
+        if (sub[i] == NULL) {
+            code = FAILED;
+        }
+        c.sub[i] = sub[i];
+    }
+    if (code == SUCCESS && k > 0) {
+        qsort(c.sub, k, sizeof(gate_instance_t *), instance_cmp);
+        for (size_t i = 1; i < k; ++i) {
+            if (c.sub[i] == c.sub[i - 1]) {
+                code = FAILED;
+            }
+        }
+    }
+    if (code != SUCCESS) {
+        signal_table_free(&c.ports);
+        free(mod);
+        free(outputs);
+        free(c.sub);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    netlist_builder_init(&c.b, n, module_resolve, &c);
+
+    for (size_t i = 0; i < m && code == SUCCESS; ++i) {
+        ssize_t slot = netlist_builder_add(&c.b, g[i]);
+        if (slot < 0) {
+            code = FAILED;
+        } else {
+            outputs[i] = (size_t) slot;
+        }
+    }
+
+    // Restoring the state of the sub-instances to their state before the compilation
+    for (size_t i = 0; i < k; ++i) {
+        c.sub[i]->state = UNVISITED;
+    }
+
+    if (code == SUCCESS) {
+        code = netlist_builder_finish(&c.b, outputs, m, &mod->nl);
+    } else {
+        netlist_builder_abort(&c.b);
+    }
+
+    int error = errno;
+    signal_table_free(&c.ports);
+    free(outputs);
+    free(c.sub);
+
+    if (code != SUCCESS) {
+        free(mod);
+        errno = error;
+        return NULL;
+    }
+
+    return mod;
+}
+
+void gate_module_delete(gate_module_t *mod) {
+    if (mod == NULL) {
+        return;
+    }
+
+    netlist_free(&mod->nl);
+    free(mod);
+}
+
+ssize_t gate_module_fan_in(gate_module_t const *mod) {
+    if (mod == NULL) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    return (ssize_t) mod->nl.n_inputs;
+}
+
+ssize_t gate_module_fan_out(gate_module_t const *mod) {
+    if (mod == NULL) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    return (ssize_t) mod->nl.n_outputs;
+}
+
+gate_instance_t *gate_instance_new(gate_module_t const *mod) {
+    if (mod == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    size_t n = mod->nl.n_inputs;
+    size_t m = mod->nl.n_outputs;
+
+    // The instance, its bindings and its outputs share a single allocation.
+    gate_instance_t *inst = malloc(sizeof(gate_instance_t) + n * sizeof(element_in) + m * sizeof(bool));
+    if (inst == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    inst->mod = mod;
+    inst->in = (element_in *) (inst + 1);
+    inst->out = (bool *) (inst->in + n);
+    inst->state = UNVISITED;
+    inst->idx = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        inst->in[i] = (element_in){.connection_type = SIGNAL, .pointer = NULL, .origin = NULL};
+    }
+    for (size_t j = 0; j < m; ++j) {
+        inst->out[j] = false;
+    }
+
+    return inst;
+}
+
+void gate_instance_delete(gate_instance_t *inst) {
+    if (inst == NULL) {
+        return;
+    }
+
+    for (size_t k = 0; k < inst->mod->nl.n_inputs; ++k) {
+        gate_port_unbind(&inst->in[k]);
+    }
+    free(inst);
+}
+
+int gate_instance_connect_gate(gate_t *g_out, gate_instance_t *inst, unsigned k) {
+    if (g_out == NULL || inst == NULL || k >= inst->mod->nl.n_inputs) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    return gate_port_bind(&inst->in[k], g_out);
+}
+
+int gate_instance_connect_signal(bool const *s, gate_instance_t *inst, unsigned k) {
+    if (s == NULL || inst == NULL || k >= inst->mod->nl.n_inputs) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    gate_port_unbind(&inst->in[k]);
+    inst->in[k] = (element_in){.connection_type = SIGNAL, .pointer = (void *) s, .origin = NULL};
+    return SUCCESS;
+}
+
+bool const *gate_instance_output(gate_instance_t const *inst, unsigned j) {
+    if (inst == NULL || j >= inst->mod->nl.n_outputs) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return &inst->out[j];
+}
+
+int gate_instance_evaluate(gate_instance_t **inst, size_t m) {
+    if (inst == NULL || m == 0) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    size_t slots = 0;
+    size_t ports = 0;
+    for (size_t i = 0; i < m; ++i) {
+        if (inst[i] == NULL) {
+            errno = EINVAL;
+            return FAILED;
+        }
+        slots = max(slots, inst[i]->mod->nl.n_slots + inst[i]->mod->nl.n_scratch);
+        ports = max(ports, inst[i]->mod->nl.n_inputs);
+    }
+
+    uint64_t *v = malloc(slots * sizeof(uint64_t));
+    gate_t **g = malloc(ports * sizeof(gate_t *));
+    bool *value = malloc(ports * sizeof(bool));
+    if ((v == NULL && slots > 0) || ((g == NULL || value == NULL) && ports > 0)) {
+        free(v);
+        free(g);
+        free(value);
+        errno = ENOMEM;
+        return FAILED;
+    }
+
+    for (size_t i = 0; i < m; ++i) {
+        netlist const *nl = &inst[i]->mod->nl;
+        size_t n_gates = 0;
+
+        for (size_t k = 0; k < nl->n_inputs; ++k) {
+            element_in const *port = &inst[i]->in[k];
+            if (port->pointer == NULL) {
+                free(v);
+                free(g);
+                free(value);
+                errno = ECANCELED;
+                return FAILED;
+            }
+
+            if (port->connection_type == GATE) {
+                g[n_gates++] = port->pointer;
+            } else {
+                v[k] = *(bool const *) port->pointer ? ~UINT64_C(0) : 0;
+            }
+        }
+
+        // All ports bound to gates are evaluated in one call, so that cones they share are computed once.
+        if (n_gates > 0 && gate_evaluate(g, value, n_gates) < 0) {
+            free(v);
+            free(g);
+            free(value);
+            return FAILED;
+        }
+
+        for (size_t k = 0, j = 0; k < nl->n_inputs; ++k) {
+            if (inst[i]->in[k].connection_type == GATE) {
+                v[k] = value[j++] ? ~UINT64_C(0) : 0;
+            }
+        }
+
+        netlist_eval(nl, v, 1);
+
+        for (size_t j = 0; j < nl->n_outputs; ++j) {
+            inst[i]->out[j] = (v[nl->outputs[j]] & 1) != 0;
+        }
+    }
+
+    free(v);
+    free(g);
+    free(value);
+    return SUCCESS;
+}
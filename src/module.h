@@ -0,0 +1,154 @@
+#ifndef MODULE_H
+#define MODULE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "gate.h"
+
+typedef struct gate_module gate_module_t;
+typedef struct gate_instance gate_instance_t;
+
+/**
+ * @brief Defines a module (a reusable subcircuit) from a prototype circuit.
+ *
+ * Compiles the circuit reachable from the `m` gates in `g` into a module with `n` input ports and `m` outputs.
+ * Input port `i` stands for the signal `s[i]`, output `j` is the output of `g[j]`. The prototype may also use
+ * instances of other modules, listed in `sub`: their inputs are bound to the prototype's gates or signals and
+ * their outputs (see `gate_instance_output`) are fed to the prototype's gates with `gate_connect_signal`.
+ * Such instances are compiled into references to the shared body of their module, so modules can be nested.
+ *
+ * The prototype gates and instances are not modified and may be deleted once the module has been created.
+ * The modules used by `sub` must outlive the created module.
+ *
+ * @param g Array of pointers to the gates whose outputs form the module outputs.
+ * @param m Size of the `g` array.
+ * @param s Array of pointers to the signals standing for the input ports. May be `NULL` if `n` is zero.
+ * @param n Size of the `s` array.
+ * @param sub Array of pointers to the instances used by the prototype. May be `NULL` if `k` is zero.
+ * @param k Size of the `sub` array.
+ * @return
+ * - Pointer to the created module on success.
+ * - `NULL` if any pointer is `NULL`, `m` is zero, `s` or `sub` contain duplicates, or a signal used by the
+ *   prototype is neither a port nor an output of an instance in `sub` (`errno` is set to `EINVAL`).
+ * - `NULL` if the prototype contains a cycle or an unconnected input (`errno` is set to `ECANCELED`).
+ * - `NULL` if memory allocation fails (`errno` is set to `ENOMEM`).
+ */
+gate_module_t *gate_module_new(gate_t **g, size_t m, bool const **s, size_t n, gate_instance_t **sub, size_t k);
+
+/**
+ * @brief Deletes the specified module.
+ *
+ * Does nothing if `mod` is `NULL`. All instances of the module, and all modules using them,
+ * must be deleted first.
+ *
+ * @param mod Pointer to the module to delete.
+ */
+void gate_module_delete(gate_module_t *mod);
+
+/**
+ * @brief Returns the number of input ports of the specified module.
+ *
+ * @param mod Pointer to the module.
+ * @return
+ * - The number of input ports.
+ * - -1 if `mod` is `NULL` (`errno` is set to `EINVAL`).
+ */
+ssize_t gate_module_fan_in(gate_module_t const *mod);
+
+/**
+ * @brief Returns the number of outputs of the specified module.
+ *
+ * @param mod Pointer to the module.
+ * @return
+ * - The number of outputs.
+ * - -1 if `mod` is `NULL` (`errno` is set to `EINVAL`).
+ */
+ssize_t gate_module_fan_out(gate_module_t const *mod);
+
+/**
+ * @brief Creates a new instance of the specified module.
+ *
+ * An instance only stores its port bindings and output values; the gates of the module are shared
+ * by all of its instances. All input ports are initially unconnected and all outputs are false.
+ *
+ * @param mod Pointer to the module.
+ * @return
+ * - Pointer to the created instance on success.
+ * - `NULL` if `mod` is `NULL` (`errno` is set to `EINVAL`).
+ * - `NULL` if memory allocation fails (`errno` is set to `ENOMEM`).
+ */
+gate_instance_t *gate_instance_new(gate_module_t const *mod);
+
+/**
+ * @brief Deletes the specified instance.
+ *
+ * Does nothing if `inst` is `NULL`. Gates connected to the outputs of the instance must be
+ * disconnected from them first.
+ *
+ * @param inst Pointer to the instance to delete.
+ */
+void gate_instance_delete(gate_instance_t *inst);
+
+/**
+ * @brief Connects the output of a gate to an input port of an instance.
+ *
+ * Any signal previously connected to the `k`-th port will be disconnected. Deleting `g_out` leaves
+ * the port unconnected. The port is not counted by `gate_fan_out(g_out)`.
+ *
+ * @param g_out Pointer to the gate.
+ * @param inst Pointer to the instance.
+ * @param k Index of the input port of `inst`.
+ * @return
+ * - 0 on success.
+ * - -1 if any pointer is `NULL` or `k` is invalid (`errno` is set to `EINVAL`).
+ * - -1 if memory allocation fails (`errno` is set to `ENOMEM`).
+ */
+int gate_instance_connect_gate(gate_t *g_out, gate_instance_t *inst, unsigned k);
+
+/**
+ * @brief Connects a boolean signal to an input port of an instance.
+ *
+ * Any signal previously connected to the `k`-th port will be disconnected.
+ *
+ * @param s Pointer to the boolean signal.
+ * @param inst Pointer to the instance.
+ * @param k Index of the input port of `inst`.
+ * @return
+ * - 0 on success.
+ * - -1 if any pointer is `NULL` or `k` is invalid (`errno` is set to `EINVAL`).
+ */
+int gate_instance_connect_signal(bool const *s, gate_instance_t *inst, unsigned k);
+
+/**
+ * @brief Returns the signal holding an output of an instance.
+ *
+ * The signal can be connected to gates with `gate_connect_signal`. It is updated by `gate_instance_evaluate`
+ * and, when the instance is part of a module prototype, identifies the output during `gate_module_new`.
+ *
+ * @param inst Pointer to the instance.
+ * @param j Index of the output.
+ * @return
+ * - Pointer to the output signal on success.
+ * - `NULL` if `inst` is `NULL` or `j` is invalid (`errno` is set to `EINVAL`).
+ */
+bool const *gate_instance_output(gate_instance_t const *inst, unsigned j);
+
+/**
+ * @brief Evaluates the outputs of the specified instances.
+ *
+ * Instances are evaluated in the order given. Ports connected to gates read the values computed
+ * by `gate_evaluate` for those gates.
+ *
+ * @param inst Array of pointers to the instances.
+ * @param m Size of the `inst` array.
+ * @return
+ * - 0 on success (the outputs of every instance are updated).
+ * - -1 if any pointer is `NULL` or `m` is zero (`errno` is set to `EINVAL`).
+ * - -1 if a port is unconnected or a connected gate cannot be evaluated (`errno` is set to `ECANCELED`).
+ * - -1 if memory allocation fails (`errno` is set to `ENOMEM`).
+ */
+int gate_instance_evaluate(gate_instance_t **inst, size_t m);
+
+#endif
@@ -0,0 +1,483 @@
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "gate_internal.h"
+#include "netlist.h"
+#include "vector.h"
+
+static size_t ptr_map_probe(ptr_map const *map, uintptr_t key) {
+    uint64_t h = (uint64_t) key * UINT64_C(0x9E3779B97F4A7C15);
+    size_t i = (size_t) (h ^ (h >> 32)) & (map->cap - 1);
+
+    while (map->keys[i] != 0 && map->keys[i] != key) {
+        i = (i + 1) & (map->cap - 1);
+    }
+
+    return i;
+}
+
+ssize_t ptr_map_find(ptr_map const *map, uintptr_t key) {
+    if (map->cap == 0) {
+        return FAILED;
+    }
+
+    size_t i = ptr_map_probe(map, key);
+    return map->keys[i] == key ? (ssize_t) map->values[i] : FAILED;
+}
+
+int ptr_map_put(ptr_map *map, uintptr_t key, size_t value) {
+    if ((map->size + 1) * 2 > map->cap) {
+        size_t cap = map->cap == 0 ? 16 : map->cap * 2;
+        uintptr_t *keys = calloc(cap, sizeof(uintptr_t));
+        size_t *values = malloc(cap * sizeof(size_t));
+        if (keys == NULL || values == NULL) {
+            free(keys);
+            free(values);
+            return FAILED;
+        }
+
+        ptr_map grown = {.keys = keys, .values = values, .cap = cap, .size = map->size};
+        for (size_t i = 0; i < map->cap; ++i) {
+            if (map->keys[i] != 0) {
+                size_t j = ptr_map_probe(&grown, map->keys[i]);
+                grown.keys[j] = map->keys[i];
+                grown.values[j] = map->values[i];
+            }
+        }
+
+        free(map->keys);
+        free(map->values);
+        *map = grown;
+    }
+
+    size_t i = ptr_map_probe(map, key);
+    if (map->keys[i] == 0) {
+        map->size++;
+    }
+    map->keys[i] = key;
+    map->values[i] = value;
+
+    return SUCCESS;
+}
+
+// Smallest power of two capacity that holds `n` keys at most half full
+static size_t ptr_map_cap(size_t n) {
+    size_t cap = 2;
+    while (cap < 2 * n) {
+        cap *= 2;
+    }
+
+    return cap;
+}
+
+size_t ptr_map_block_size(size_t n) {
+    return ptr_map_cap(n) * (sizeof(uintptr_t) + sizeof(size_t));
+}
+
+ptr_map ptr_map_place(void *block, size_t n) {
+    size_t cap = ptr_map_cap(n);
+    uintptr_t *keys = block;
+
+    memset(keys, 0, cap * sizeof(uintptr_t));
+    return (ptr_map){.keys = keys, .values = (size_t *) (keys + cap), .cap = cap, .size = 0};
+}
+
+void ptr_map_free(ptr_map *map) {
+    free(map->keys);
+    free(map->values);
+    *map = (ptr_map){0};
+}
+
+// Grows the array under `data` so that it can hold at least `need` elements of `size` bytes
+static int reserve(void **data, size_t *cap, size_t need, size_t size) {
+    if (need <= *cap) {
+        return SUCCESS;
+    }
+
+    size_t new_cap = *cap == 0 ? 16 : *cap;
+    while (new_cap < need) {
+        new_cap *= 2;
+    }
+
+    void *new_data = realloc(*data, new_cap * size);
+    if (new_data == NULL) {
+        return FAILED;
+    }
+
+    *data = new_data;
+    *cap = new_cap;
+    return SUCCESS;
+}
+
+static int signal_column_cmp(void const *a, void const *b) {
+    uintptr_t x = (uintptr_t) ((signal_column const *) a)->signal;
+    uintptr_t y = (uintptr_t) ((signal_column const *) b)->signal;
+    return (x > y) - (x < y);
+}
+
+int signal_table_init(signal_table *t, bool const **s, size_t n) {
+    t->data = NULL;
+    t->size = 0;
+    if (n == 0) {
+        return SUCCESS;
+    }
+
+    t->data = malloc(n * sizeof(signal_column));
+    if (t->data == NULL) {
+        errno = ENOMEM;
+        return FAILED;
+    }
+    t->size = n;
+
+    for (size_t i = 0; i < n; ++i) {
+        t->data[i] = (signal_column){.signal = s[i], .col = i};
+    }
+    qsort(t->data, n, sizeof(signal_column), signal_column_cmp);
+
+    for (size_t i = 0; i < n; ++i) {
+        if (t->data[i].signal == NULL || (i > 0 && t->data[i].signal == t->data[i - 1].signal)) {
+            signal_table_free(t);
+            errno = EINVAL;
+            return FAILED;
+        }
+    }
+
+    return SUCCESS;
+}
+
+ssize_t signal_table_find(signal_table const *t, bool const *s) {
+    if (t->size == 0) {
+        return FAILED;
+    }
+
+    signal_column key = {.signal = s};
+    signal_column const *found = bsearch(&key, t->data, t->size, sizeof(signal_column), signal_column_cmp);
+
+    return found == NULL ? FAILED : (ssize_t) found->col;
+}
+
+ssize_t signal_table_resolve(void *ctx, bool const *s) {
+    ssize_t col = signal_table_find(ctx, s);
+    if (col < 0) {
+        errno = EINVAL;
+    }
+
+    return col;
+}
+
+void signal_table_free(signal_table *t) {
+    free(t->data);
+    t->data = NULL;
+    t->size = 0;
+}
+
+ssize_t signal_slots_resolve(void *ctx, bool const *s) {
+    signal_slots *c = ctx;
+
+    ssize_t slot = ptr_map_find(&c->map, (uintptr_t) s);
+    if (slot >= 0) {
+        return slot;
+    }
+
+    if (c->size == c->cap) {
+        size_t cap = c->cap == 0 ? 16 : c->cap * 2;
+        slot_signal *signals = realloc(c->data, cap * sizeof(slot_signal));
+        if (signals == NULL) {
+            errno = ENOMEM;
+            return FAILED;
+        }
+        c->data = signals;
+        c->cap = cap;
+    }
+
+    size_t new_slot = netlist_builder_slot(c->b);
+    if (ptr_map_put(&c->map, (uintptr_t) s, new_slot) != SUCCESS) {
+        errno = ENOMEM;
+        return FAILED;
+    }
+    c->data[c->size++] = (slot_signal){.slot = new_slot, .signal = s};
+
+    return (ssize_t) new_slot;
+}
+
+void signal_slots_free(signal_slots *c) {
+    ptr_map_free(&c->map);
+    free(c->data);
+    c->data = NULL;
+    c->size = c->cap = 0;
+}
+
+int netlist_kind_op(gate_kind_t kind, netlist_op *op, bool *negate) {
+    switch (kind) {
+        case NAND:
+        case AND:
+            *op = OP_AND;
+            break;
+        case OR:
+        case NOR:
+            *op = OP_OR;
+            break;
+        case XOR:
+        case XNOR:
+            *op = OP_XOR;
+            break;
+        default:
+            return FAILED;
+    }
+
+    *negate = kind == NAND || kind == NOR || kind == XNOR;
+    return SUCCESS;
+}
+
+// Restores the state of every compiled gate and releases the builder's memory
+static void netlist_builder_release(netlist_builder *b) {
+    for (size_t i = 0; i < b->n_gates; ++i) {
+        if (b->gates[i] != NULL) {
+            b->gates[i]->state = UNVISITED;
+        }
+    }
+
+    free(b->nodes);
+    free(b->srcs);
+    free(b->gates);
+    b->nodes = NULL;
+    b->srcs = NULL;
+    b->gates = NULL;
+    b->n_nodes = b->cap_nodes = b->n_srcs = b->cap_srcs = b->n_gates = b->cap_gates = 0;
+}
+
+void netlist_builder_init(netlist_builder *b, size_t n_inputs, netlist_resolve_fn resolve, void *ctx) {
+    b->resolve = resolve;
+    b->ctx = ctx;
+    b->n_inputs = n_inputs;
+    b->n_slots = n_inputs;
+    b->n_scratch = 0;
+    b->nodes = NULL;
+    b->n_nodes = 0;
+    b->cap_nodes = 0;
+    b->srcs = NULL;
+    b->n_srcs = 0;
+    b->cap_srcs = 0;
+    b->gates = NULL;
+    b->n_gates = 0;
+    b->cap_gates = 0;
+}
+
+ssize_t netlist_builder_add(netlist_builder *b, gate_t *g) {
+    if (g->state == CALCULATED) {
+        return (ssize_t) g->idx;
+    }
+
+    netlist_op op;
+    bool negate;
+    if (g->state == VISITED || vector_in_size(g->in) != vector_in_capacity(g->in) ||
+        netlist_kind_op(g->kind, &op, &negate) != SUCCESS) {
+        // A cycle, an unconnected input or an unknown gate kind
+        errno = ECANCELED;
+        return FAILED;
+    }
+
+    g->state = VISITED;
+
+    size_t n = vector_in_capacity(g->in);
+
+    // Everything feeding this gate is compiled first, so that the inputs of a node stay contiguous in `srcs`.
+    for (size_t i = 0; i < n; ++i) {
+        element_in *in_value = get_element_in_at_index(g->in, i);
+        ssize_t slot = in_value->connection_type == GATE ? netlist_builder_add(b, in_value->pointer)
+                                                         : b->resolve(b->ctx, in_value->pointer);
+        if (slot < 0) {
+            g->state = UNVISITED;
+            return FAILED;
+        }
+    }
+
+    // Gates keep their slot in an unsigned field.
+    if (b->n_slots > UINT_MAX ||
+        reserve((void **) &b->srcs, &b->cap_srcs, b->n_srcs + n, sizeof(size_t)) != SUCCESS ||
+        reserve((void **) &b->nodes, &b->cap_nodes, b->n_nodes + 1, sizeof(netlist_node)) != SUCCESS ||
+        reserve((void **) &b->gates, &b->cap_gates, b->n_gates + 1, sizeof(gate_t *)) != SUCCESS) {
+        g->state = UNVISITED;
+        errno = ENOMEM;
+        return FAILED;
+    }
+
+    size_t first = b->n_srcs;
+    for (size_t i = 0; i < n; ++i) {
+        element_in *in_value = get_element_in_at_index(g->in, i);
+        if (in_value->connection_type == GATE) {
+            b->srcs[b->n_srcs++] = ((gate_t *) in_value->pointer)->idx;
+            continue;
+        }
+
+        ssize_t col = b->resolve(b->ctx, in_value->pointer);
+        if (col < 0) {
+            b->n_srcs = first;
+            g->state = UNVISITED;
+            return FAILED;
+        }
+        b->srcs[b->n_srcs++] = (size_t) col;
+    }
+
+    g->idx = (unsigned) b->n_slots++;
+    b->nodes[b->n_nodes++] = (netlist_node){.op = op, .negate = negate, .n_in = n, .in = first, .dst = g->idx};
+    b->gates[b->n_gates++] = g;
+    g->state = CALCULATED;
+
+    return (ssize_t) g->idx;
+}
+
+size_t netlist_builder_slot(netlist_builder *b) {
+    return b->n_slots++;
+}
+
+ssize_t netlist_builder_call(netlist_builder *b, netlist const *callee, size_t const *srcs) {
+    if (reserve((void **) &b->srcs, &b->cap_srcs, b->n_srcs + callee->n_inputs, sizeof(size_t)) != SUCCESS ||
+        reserve((void **) &b->nodes, &b->cap_nodes, b->n_nodes + 1, sizeof(netlist_node)) != SUCCESS ||
+        reserve((void **) &b->gates, &b->cap_gates, b->n_gates + 1, sizeof(gate_t *)) != SUCCESS) {
+        errno = ENOMEM;
+        return FAILED;
+    }
+
+    size_t first = b->n_srcs;
+    if (callee->n_inputs > 0) {
+        memcpy(b->srcs + first, srcs, callee->n_inputs * sizeof(size_t));
+    }
+    b->n_srcs += callee->n_inputs;
+
+    size_t dst = b->n_slots;
+    b->n_slots += callee->n_outputs;
+    b->nodes[b->n_nodes++] = (netlist_node){
+            .op = OP_CALL, .n_in = callee->n_inputs, .in = first, .dst = dst, .callee = callee};
+    b->gates[b->n_gates++] = NULL;
+
+    // Callees run one at a time, so they all share the scratch area behind the caller's slots.
+    b->n_scratch = max(b->n_scratch, callee->n_slots + callee->n_scratch);
+
+    return (ssize_t) dst;
+}
+
+int netlist_builder_finish(netlist_builder *b, size_t const *outputs, size_t m, netlist *nl) {
+    size_t nodes_size = b->n_nodes * sizeof(netlist_node);
+    size_t srcs_size = b->n_srcs * sizeof(size_t);
+
+    // One block for the whole netlist keeps the evaluation loop on contiguous memory.
+    char *block = malloc(nodes_size + srcs_size + m * sizeof(size_t));
+    if (block == NULL) {
+        netlist_builder_release(b);
+        errno = ENOMEM;
+        return FAILED;
+    }
+
+    nl->n_inputs = b->n_inputs;
+    nl->n_slots = b->n_slots;
+    nl->n_scratch = b->n_scratch;
+    nl->n_nodes = b->n_nodes;
+    nl->n_outputs = m;
+    nl->nodes = (netlist_node *) block;
+    nl->srcs = (size_t *) (block + nodes_size);
+    nl->outputs = (size_t *) (block + nodes_size + srcs_size);
+
+    if (b->n_nodes > 0) {
+        memcpy(nl->nodes, b->nodes, nodes_size);
+    }
+    if (b->n_srcs > 0) {
+        memcpy(nl->srcs, b->srcs, srcs_size);
+    }
+    memcpy(nl->outputs, outputs, m * sizeof(size_t));
+
+    netlist_builder_release(b);
+    return SUCCESS;
+}
+
+void netlist_builder_abort(netlist_builder *b) {
+    netlist_builder_release(b);
+}
+
+int netlist_compile(netlist *nl, gate_t **g, size_t m, size_t n_inputs, netlist_resolve_fn resolve, void *ctx) {
+    size_t *outputs = malloc(m * sizeof(size_t));
+    if (outputs == NULL) {
+        errno = ENOMEM;
+        return FAILED;
+    }
+
+    netlist_builder b;
+    netlist_builder_init(&b, n_inputs, resolve, ctx);
+
+    for (size_t i = 0; i < m; ++i) {
+        ssize_t slot = netlist_builder_add(&b, g[i]);
+        if (slot < 0) {
+            netlist_builder_abort(&b);
+            free(outputs);
+            return FAILED;
+        }
+        outputs[i] = (size_t) slot;
+    }
+
+    int code = netlist_builder_finish(&b, outputs, m, nl);
+    free(outputs);
+    return code;
+}
+
+void netlist_free(netlist *nl) {
+    free(nl->nodes);
+    nl->nodes = NULL;
+    nl->srcs = NULL;
+    nl->outputs = NULL;
+    nl->n_inputs = nl->n_slots = nl->n_scratch = nl->n_nodes = nl->n_outputs = 0;
+}
+
+void netlist_eval(netlist const *nl, uint64_t *v, size_t w) {
+    for (size_t i = 0; i < nl->n_nodes; ++i) {
+        netlist_node const *node = &nl->nodes[i];
+        size_t const *src = nl->srcs + node->in;
+        uint64_t *dst = v + node->dst * w;
+
+        if (node->op == OP_CALL) {
+            netlist const *callee = node->callee;
+            uint64_t *callee_v = v + nl->n_slots * w;
+
+            for (size_t j = 0; j < node->n_in; ++j) {
+                memcpy(callee_v + j * w, v + src[j] * w, w * sizeof(uint64_t));
+            }
+            netlist_eval(callee, callee_v, w);
+            for (size_t j = 0; j < callee->n_outputs; ++j) {
+                memcpy(dst + j * w, callee_v + callee->outputs[j] * w, w * sizeof(uint64_t));
+            }
+            continue;
+        }
+
+        uint64_t init = node->op == OP_AND ? ~UINT64_C(0) : 0;
+        for (size_t k = 0; k < w; ++k) {
+            dst[k] = init;
+        }
+
+        for (size_t j = 0; j < node->n_in; ++j) {
+            uint64_t const *s = v + src[j] * w;
+            switch (node->op) {
+                case OP_AND:
+                    for (size_t k = 0; k < w; ++k) dst[k] &= s[k];
+                    break;
+                case OP_OR:
+                    for (size_t k = 0; k < w; ++k) dst[k] |= s[k];
+                    break;
+                case OP_XOR:
+                    for (size_t k = 0; k < w; ++k) dst[k] ^= s[k];
+                    break;
+                case OP_CALL:
+                    break;
+            }
+        }
+
+        if (node->negate) {
+            for (size_t k = 0; k < w; ++k) {
+                dst[k] = ~dst[k];
+            }
+        }
+    }
+}
@@ -0,0 +1,168 @@
+#ifndef NETLIST_H
+#define NETLIST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "gate.h"
+
+/*
+ * A netlist is a flat, topologically ordered form of the circuit reachable from a set of gates.
+ * Values live in "slots": slots [0, n_inputs) are input columns supplied by the caller, the remaining
+ * slots hold node outputs. Every slot is `w` consecutive 64-bit words, so a single pass evaluates
+ * 64 * w independent input vectors at once.
+ *
+ * An OP_CALL node evaluates another (shared) netlist, the callee, on its inputs and writes the callee's
+ * outputs to consecutive slots starting at `dst`. The callee's slots are placed in the n_scratch slots
+ * following the caller's own ones, so evaluation needs n_slots + n_scratch slots in total.
+ */
+
+typedef enum netlist_op {
+    OP_AND,
+    OP_OR,
+    OP_XOR,
+    OP_CALL,
+} netlist_op;
+
+typedef struct netlist netlist;
+
+// Marks a slot that is not written by any node, i.e. read from a signal
+#define NO_NODE SIZE_MAX
+
+typedef struct netlist_node netlist_node;
+struct netlist_node {
+    netlist_op op;
+    bool negate;
+    size_t n_in;
+    size_t in;  // Offset of the node's first input slot in the `srcs` array.
+    size_t dst; // Slot receiving the node's (first) output.
+    netlist const *callee; // Netlist evaluated by an OP_CALL node.
+};
+
+struct netlist {
+    size_t n_inputs;
+    size_t n_slots;
+    size_t n_scratch;
+    size_t n_nodes;
+    size_t n_outputs;
+    netlist_node *nodes; // Start of the single allocation block holding all arrays.
+    size_t *srcs;
+    size_t *outputs; // Slot of each requested gate.
+};
+
+// Maps a signal connected with `gate_connect_signal` to its slot, or returns -1 and sets `errno`.
+// It may be called more than once for the same signal and may itself add nodes to the builder.
+typedef ssize_t (*netlist_resolve_fn)(void *ctx, bool const *s);
+
+// Sorted mapping of signals to input columns
+typedef struct signal_column {
+    bool const *signal;
+    size_t col;
+} signal_column;
+
+typedef struct signal_table {
+    signal_column *data;
+    size_t size;
+} signal_table;
+
+// Maps `s[i]` to column `i`. Fails with `EINVAL` on `NULL` or duplicate signals, or with `ENOMEM`.
+int signal_table_init(signal_table *t, bool const **s, size_t n);
+
+// Returns the column of `s`, or -1 if `s` is not in the table.
+ssize_t signal_table_find(signal_table const *t, bool const *s);
+
+// Resolver over the signal table `ctx`: signals missing from the table fail with `EINVAL`.
+ssize_t signal_table_resolve(void *ctx, bool const *s);
+
+void signal_table_free(signal_table *t);
+
+// Open-addressing hash map from non-zero keys to indices
+typedef struct ptr_map {
+    uintptr_t *keys; // 0 marks an empty place
+    size_t *values;
+    size_t cap; // Power of two, at least twice the size
+    size_t size;
+} ptr_map;
+
+// Returns the value stored under `key`, or -1 if there is none.
+ssize_t ptr_map_find(ptr_map const *map, uintptr_t key);
+
+// Inserts the key, growing the map if needed. A map placed in a caller's block must be sized up front.
+int ptr_map_put(ptr_map *map, uintptr_t key, size_t value);
+
+void ptr_map_free(ptr_map *map);
+
+// Size in bytes of a map for `n` keys placed in a caller's block with `ptr_map_place`.
+size_t ptr_map_block_size(size_t n);
+
+// Returns an empty map for `n` keys stored in `block` of `ptr_map_block_size(n)` bytes. Inserting up to `n` keys
+// never grows it, so `ptr_map_put` cannot fail; the map is released with its block, not with `ptr_map_free`.
+ptr_map ptr_map_place(void *block, size_t n);
+
+typedef struct netlist_builder netlist_builder;
+struct netlist_builder {
+    netlist_resolve_fn resolve;
+    void *ctx;
+    size_t n_inputs;
+    size_t n_slots;
+    size_t n_scratch;
+    netlist_node *nodes;
+    size_t n_nodes;
+    size_t cap_nodes;
+    size_t *srcs;
+    size_t n_srcs;
+    size_t cap_srcs;
+    gate_t **gates; // Gate of every node, so gates[i] belongs to nodes[i]; NULL for OP_CALL nodes.
+    size_t n_gates;
+    size_t cap_gates;
+};
+
+// Translates a gate kind into the reduction performed over its inputs; fails for an unknown kind.
+int netlist_kind_op(gate_kind_t kind, netlist_op *op, bool *negate);
+
+typedef struct slot_signal {
+    size_t slot;
+    bool const *signal;
+} slot_signal;
+
+// Resolver context which gives every distinct signal met by the builder `b` its own slot
+typedef struct signal_slots {
+    netlist_builder *b;
+    ptr_map map; // Signal -> slot
+    slot_signal *data;
+    size_t size;
+    size_t cap;
+} signal_slots;
+
+ssize_t signal_slots_resolve(void *ctx, bool const *s);
+
+void signal_slots_free(signal_slots *c);
+
+void netlist_builder_init(netlist_builder *b, size_t n_inputs, netlist_resolve_fn resolve, void *ctx);
+
+// Compiles `g` and everything it depends on, returning the slot holding its output or -1 (`errno` is set).
+ssize_t netlist_builder_add(netlist_builder *b, gate_t *g);
+
+// Reserves a slot that is not written by any node, e.g. for a signal discovered by `resolve`.
+size_t netlist_builder_slot(netlist_builder *b);
+
+// Adds a call of `callee` reading its inputs from `srcs`, returning the slot of its first output or -1.
+ssize_t netlist_builder_call(netlist_builder *b, netlist const *callee, size_t const *srcs);
+
+// Packs the compiled nodes into `nl` with the given output slots. Always releases the builder.
+int netlist_builder_finish(netlist_builder *b, size_t const *outputs, size_t m, netlist *nl);
+
+// Releases the builder without producing a netlist.
+void netlist_builder_abort(netlist_builder *b);
+
+// Compiles the circuit reachable from the `m` gates in `g`, with signals mapped to columns by `resolve`.
+int netlist_compile(netlist *nl, gate_t **g, size_t m, size_t n_inputs, netlist_resolve_fn resolve, void *ctx);
+
+void netlist_free(netlist *nl);
+
+// Evaluates every node; `v` holds (n_slots + n_scratch) slots of `w` words with the input slots filled in.
+void netlist_eval(netlist const *nl, uint64_t *v, size_t w);
+
+#endif
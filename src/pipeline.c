@@ -0,0 +1,285 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "gate_internal.h"
+#include "netlist.h"
+#include "pipeline.h"
+
+// Number of 64-bit words per slot evaluated in one pass, i.e. a block holds 64 * PIPELINE_WORDS vectors
+#define PIPELINE_WORDS 8
+#define PIPELINE_BLOCK (64 * PIPELINE_WORDS)
+
+struct gate_pipeline {
+    netlist nl;
+    size_t in_row;  // Size of an input vector in bytes
+    size_t out_row; // Size of an output vector in bytes
+};
+
+// State shared by all workers of a single `gate_pipeline_run` call
+typedef struct pipeline_job {
+    gate_pipeline_t const *p;
+    unsigned char const *in;
+    int fd;
+    size_t n_vectors;
+    size_t n_blocks;
+    atomic_size_t next; // Index of the next block to evaluate
+    atomic_int error;   // `errno` of the first failure, 0 if none
+} pipeline_job;
+
+gate_pipeline_t *gate_pipeline_new(gate_t **g, size_t m, bool const **s, size_t n) {
+    if (g == NULL || s == NULL || m == 0 || n == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    for (size_t i = 0; i < m; ++i) {
+        if (g[i] == NULL) {
+            errno = EINVAL;
+            return NULL;
+        }
+    }
+
+    signal_table table;
+    if (signal_table_init(&table, s, n) != SUCCESS) {
+        return NULL;
+    }
+
+    gate_pipeline_t *p = malloc(sizeof(gate_pipeline_t));
+    if (p == NULL) {
+        signal_table_free(&table);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    int code = netlist_compile(&p->nl, g, m, n, signal_table_resolve, &table);
+    signal_table_free(&table);
+    if (code != SUCCESS) {
+        free(p);
+        return NULL;
+    }
+
+    p->in_row = (n + 7) / 8;
+    p->out_row = (m + 7) / 8;
+
+    return p;
+}
+
+void gate_pipeline_delete(gate_pipeline_t *p) {
+    if (p == NULL) {
+        return;
+    }
+
+    netlist_free(&p->nl);
+    free(p);
+}
+
+// Scatters `count` packed input vectors into one bit per vector in every input slot
+static void pipeline_load(gate_pipeline_t const *p, unsigned char const *rows, size_t count, uint64_t *v) {
+    size_t n = p->nl.n_inputs;
+    memset(v, 0, n * PIPELINE_WORDS * sizeof(uint64_t));
+
+    for (size_t r = 0; r < count; ++r) {
+        unsigned char const *row = rows + r * p->in_row;
+        uint64_t bit = UINT64_C(1) << (r % 64);
+        size_t word = r / 64;
+
+        for (size_t b = 0; b < p->in_row; ++b) {
+            unsigned x = row[b];
+            while (x != 0) {
+                size_t col = b * 8 + (size_t) __builtin_ctz(x);
+                if (col < n) {
+                    v[col * PIPELINE_WORDS + word] |= bit;
+                }
+                x &= x - 1;
+            }
+        }
+    }
+}
+
+// Gathers the output slots back into `count` packed output vectors
+static void pipeline_store(gate_pipeline_t const *p, uint64_t const *v, size_t count, unsigned char *rows) {
+    memset(rows, 0, count * p->out_row);
+
+    for (size_t j = 0; j < p->nl.n_outputs; ++j) {
+        uint64_t const *s = v + p->nl.outputs[j] * PIPELINE_WORDS;
+        unsigned char mask = (unsigned char) (1u << (j % 8));
+
+        for (size_t word = 0; word * 64 < count; ++word) {
+            uint64_t x = s[word];
+            if (count - word * 64 < 64) {
+                x &= (UINT64_C(1) << (count - word * 64)) - 1;
+            }
+
+            while (x != 0) {
+                size_t r = word * 64 + (size_t) __builtin_ctzll(x);
+                rows[r * p->out_row + j / 8] |= mask;
+                x &= x - 1;
+            }
+        }
+    }
+}
+
+static int write_all(int fd, unsigned char const *buf, size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t written = pwrite(fd, buf, size, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return FAILED;
+        }
+
+        buf += written;
+        size -= (size_t) written;
+        offset += written;
+    }
+
+    return SUCCESS;
+}
+
+static void *pipeline_worker(void *arg) {
+    pipeline_job *job = arg;
+    gate_pipeline_t const *p = job->p;
+
+    uint64_t *v = malloc((p->nl.n_slots + p->nl.n_scratch) * PIPELINE_WORDS * sizeof(uint64_t));
+    unsigned char *out = malloc(PIPELINE_BLOCK * p->out_row);
+    if (v == NULL || out == NULL) {
+        free(v);
+        free(out);
+        int expected = 0;
+        atomic_compare_exchange_strong(&job->error, &expected, ENOMEM);
+        return NULL;
+    }
+
+    for (;;) {
+        size_t block = atomic_fetch_add(&job->next, 1);
+        if (block >= job->n_blocks || atomic_load(&job->error) != 0) {
+            break;
+        }
+
+        size_t first = block * PIPELINE_BLOCK;
+        size_t count = job->n_vectors - first < PIPELINE_BLOCK ? job->n_vectors - first : PIPELINE_BLOCK;
+
+        pipeline_load(p, job->in + first * p->in_row, count, v);
+        netlist_eval(&p->nl, v, PIPELINE_WORDS);
+        pipeline_store(p, v, count, out);
+
+        // Every block has a fixed place in the output file, so blocks finishing out of order are still written in order.
+        if (write_all(job->fd, out, count * p->out_row, (off_t) (first * p->out_row)) != SUCCESS) {
+            int expected = 0;
+            atomic_compare_exchange_strong(&job->error, &expected, errno);
+            break;
+        }
+    }
+
+    free(v);
+    free(out);
+    return NULL;
+}
+
+int gate_pipeline_run(gate_pipeline_t const *p, char const *in_path, char const *out_path, unsigned threads) {
+    if (p == NULL || in_path == NULL || out_path == NULL) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    int in_fd = open(in_path, O_RDONLY);
+    if (in_fd < 0) {
+        return FAILED;
+    }
+
+    struct stat st;
+    if (fstat(in_fd, &st) != 0) {
+        close(in_fd);
+        return FAILED;
+    }
+
+    size_t size = (size_t) st.st_size;
+    if (size % p->in_row != 0) {
+        close(in_fd);
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    void *in = NULL;
+    if (size > 0) {
+        in = mmap(NULL, size, PROT_READ, MAP_PRIVATE, in_fd, 0);
+        if (in == MAP_FAILED) {
+            close(in_fd);
+            return FAILED;
+        }
+        madvise(in, size, MADV_SEQUENTIAL);
+    }
+    close(in_fd);
+
+    pipeline_job job = {
+            .p = p,
+            .in = in,
+            .n_vectors = size / p->in_row,
+    };
+    job.n_blocks = (job.n_vectors + PIPELINE_BLOCK - 1) / PIPELINE_BLOCK;
+    atomic_init(&job.next, 0);
+    atomic_init(&job.error, 0);
+
+    job.fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (job.fd < 0 || ftruncate(job.fd, (off_t) (job.n_vectors * p->out_row)) != 0) {
+        int error = errno;
+        if (job.fd >= 0) {
+            close(job.fd);
+        }
+        if (in != NULL) {
+            munmap(in, size);
+        }
+        errno = error;
+        return FAILED;
+    }
+
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (unsigned) online : 1;
+    }
+    if (threads > job.n_blocks) {
+        threads = job.n_blocks > 0 ? (unsigned) job.n_blocks : 1;
+    }
+
+    pthread_t *workers = malloc((threads - 1) * sizeof(pthread_t));
+    size_t started = 0;
+    if (workers != NULL) {
+        while (started < threads - 1 && pthread_create(&workers[started], NULL, pipeline_worker, &job) == 0) {
+            started++;
+        }
+    }
+
+    // The calling thread works too, so the run makes progress even if no thread could be started.
+    pipeline_worker(&job);
+
+    for (size_t i = 0; i < started; ++i) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+
+    int error = atomic_load(&job.error);
+    if (close(job.fd) != 0 && error == 0) {
+        error = errno;
+    }
+    if (in != NULL) {
+        munmap(in, size);
+    }
+
+    if (error != 0) {
+        errno = error;
+        return FAILED;
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,62 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gate.h"
+
+typedef struct gate_pipeline gate_pipeline_t;
+
+/**
+ * @brief Compiles a circuit for replaying packed input-vector files.
+ *
+ * Compiles the circuit reachable from the `m` gates in `g` into a flat form that evaluates
+ * many input vectors at once. Column `i` of every input vector drives the signal `s[i]`, i.e. every
+ * gate input connected to `s[i]` with `gate_connect_signal`. The circuit itself is not modified and
+ * may be changed or deleted once the pipeline has been created.
+ *
+ * @param g Array of pointers to the gates whose outputs form the output vectors.
+ * @param m Size of the `g` array.
+ * @param s Array of pointers to the signals fed from the input columns.
+ * @param n Size of the `s` array.
+ * @return
+ * - Pointer to the created pipeline on success.
+ * - `NULL` if any pointer is `NULL`, `m` or `n` is zero, `s` contains duplicates, or a signal used by the
+ *   circuit is missing from `s` (`errno` is set to `EINVAL`).
+ * - `NULL` if the circuit contains a cycle or an unconnected input (`errno` is set to `ECANCELED`).
+ * - `NULL` if memory allocation fails (`errno` is set to `ENOMEM`).
+ */
+gate_pipeline_t *gate_pipeline_new(gate_t **g, size_t m, bool const **s, size_t n);
+
+/**
+ * @brief Deletes the specified pipeline.
+ *
+ * Does nothing if `p` is `NULL`.
+ *
+ * @param p Pointer to the pipeline to delete.
+ */
+void gate_pipeline_delete(gate_pipeline_t *p);
+
+/**
+ * @brief Evaluates every input vector of a file and writes the output vectors to another file.
+ *
+ * The input file is a sequence of vectors of `(n + 7) / 8` bytes each, where bit `i % 8` of byte `i / 8`
+ * holds column `i`. The input file is memory-mapped and split into blocks which are evaluated bit-parallel
+ * by `threads` workers. The output file is created (or truncated) and receives, in the same order, one
+ * vector of `(m + 7) / 8` bytes per input vector, where bit `j % 8` of byte `j / 8` holds the output of `g[j]`.
+ * Memory usage is bounded by a fixed-size buffer per worker, regardless of the size of the files.
+ *
+ * @param p Pointer to the pipeline.
+ * @param in_path Path to the input-vector file.
+ * @param out_path Path to the output-vector file. It must be a regular file.
+ * @param threads Number of worker threads, or 0 to use one per online processor.
+ * @return
+ * - 0 on success.
+ * - -1 if any pointer is `NULL` or the input file size is not a multiple of the vector size
+ *   (`errno` is set to `EINVAL`).
+ * - -1 if a file operation or memory allocation fails (`errno` is set by the failing call, e.g. `ENOENT` or `ENOMEM`).
+ */
+int gate_pipeline_run(gate_pipeline_t const *p, char const *in_path, char const *out_path, unsigned threads);
+
+#endif
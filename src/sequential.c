@@ -0,0 +1,330 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "gate_internal.h"
+#include "netlist.h"
+#include "sequential.h"
+#include "vector.h"
+
+struct gate_reg {
+    element_in d; // Input of the register, `pointer` is NULL when unconnected
+    bool q;
+};
+
+struct gate_seq {
+    netlist nl; // Outputs: the observed gates, then the inputs of the registers
+    size_t n_in;
+    size_t n_regs;
+    size_t n_out;
+    size_t w;    // Words per value
+    uint64_t *v; // All slots; the registers hold their current outputs in slots [n_in, n_in + n_regs).
+    uint64_t *next; // Values latched by the registers at the end of the current cycle
+};
+
+gate_reg_t *gate_reg_new(bool init) {
+    gate_reg_t *r = malloc(sizeof(gate_reg_t));
+    if (r == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    r->d = (element_in){.connection_type = SIGNAL, .pointer = NULL, .origin = NULL};
+    r->q = init;
+
+    return r;
+}
+
+void gate_reg_delete(gate_reg_t *r) {
+    if (r == NULL) {
+        return;
+    }
+
+    gate_port_unbind(&r->d);
+    free(r);
+}
+
+int gate_reg_connect_gate(gate_t *g_out, gate_reg_t *r) {
+    if (g_out == NULL || r == NULL) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    return gate_port_bind(&r->d, g_out);
+}
+
+int gate_reg_connect_signal(bool const *s, gate_reg_t *r) {
+    if (s == NULL || r == NULL) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    gate_port_unbind(&r->d);
+    r->d = (element_in){.connection_type = SIGNAL, .pointer = (void *) s, .origin = NULL};
+    return SUCCESS;
+}
+
+bool const *gate_reg_output(gate_reg_t const *r) {
+    if (r == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return &r->q;
+}
+
+int gate_reg_tick(gate_reg_t **r, size_t n) {
+    if (r == NULL || n == 0) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (r[i] == NULL) {
+            errno = EINVAL;
+            return FAILED;
+        }
+    }
+
+    bool *next = malloc(n * sizeof(bool));
+    gate_t **g = malloc(n * sizeof(gate_t *));
+    bool *value = malloc(n * sizeof(bool));
+    if (next == NULL || g == NULL || value == NULL) {
+        free(next);
+        free(g);
+        free(value);
+        errno = ENOMEM;
+        return FAILED;
+    }
+
+    size_t n_gates = 0;
+    for (size_t i = 0; i < n; ++i) {
+        element_in const *d = &r[i]->d;
+        if (d->pointer == NULL) {
+            free(next);
+            free(g);
+            free(value);
+            errno = ECANCELED;
+            return FAILED;
+        }
+
+        if (d->connection_type == GATE) {
+            g[n_gates++] = d->pointer;
+        } else {
+            next[i] = *(bool const *) d->pointer;
+        }
+    }
+
+    // All inputs bound to gates are evaluated in one call, so that cones they share are computed once.
+    if (n_gates > 0 && gate_evaluate(g, value, n_gates) < 0) {
+        free(next);
+        free(g);
+        free(value);
+        return FAILED;
+    }
+
+    for (size_t i = 0, j = 0; i < n; ++i) {
+        if (r[i]->d.connection_type == GATE) {
+            next[i] = value[j++];
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        r[i]->q = next[i];
+    }
+
+    free(next);
+    free(g);
+    free(value);
+    return SUCCESS;
+}
+
+// Compiles the observed gates and the register inputs into `nl`, with the inputs and then the register
+// outputs as its input columns
+static int seq_compile(netlist *nl, gate_reg_t **r, size_t n, gate_t **g, size_t m, bool const **s, size_t k) {
+    bool const **columns = malloc((k + n) * sizeof(bool const *));
+    size_t *outputs = malloc((m + n) * sizeof(size_t));
+    if (columns == NULL || outputs == NULL) {
+        free(columns);
+        free(outputs);
+        errno = ENOMEM;
+        return FAILED;
+    }
+
+    for (size_t i = 0; i < k; ++i) {
+        columns[i] = s[i];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        columns[k + i] = &r[i]->q;
+    }
+
+    signal_table table;
+    int code = signal_table_init(&table, columns, k + n);
+    free(columns);
+    if (code != SUCCESS) {
+        free(outputs);
+        return FAILED;
+    }
+
+    netlist_builder b;
+    netlist_builder_init(&b, k + n, signal_table_resolve, &table);
+
+    for (size_t i = 0; i < m + n; ++i) {
+        ssize_t slot;
+        if (i < m) {
+            slot = netlist_builder_add(&b, g[i]);
+        } else {
+            element_in const *d = &r[i - m]->d;
+            if (d->pointer == NULL) {
+                errno = ECANCELED;
+                slot = FAILED;
+            } else if (d->connection_type == GATE) {
+                slot = netlist_builder_add(&b, d->pointer);
+            } else {
+                slot = signal_table_resolve(&table, d->pointer);
+            }
+        }
+
+        if (slot < 0) {
+            int error = errno;
+            netlist_builder_abort(&b);
+            signal_table_free(&table);
+            free(outputs);
+            errno = error;
+            return FAILED;
+        }
+        outputs[i] = (size_t) slot;
+    }
+
+    code = netlist_builder_finish(&b, outputs, m + n, nl);
+    signal_table_free(&table);
+    free(outputs);
+    return code;
+}
+
+gate_seq_t *gate_seq_new(gate_reg_t **r, size_t n, gate_t **g, size_t m, bool const **s, size_t k, size_t runs) {
+    if (r == NULL || n == 0 || (g == NULL && m > 0) || (s == NULL && k > 0) || runs == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (r[i] == NULL) {
+            errno = EINVAL;
+            return NULL;
+        }
+    }
+
+    for (size_t i = 0; i < m; ++i) {
+        if (g[i] == NULL) {
+            errno = EINVAL;
+            return NULL;
+        }
+    }
+
+    netlist nl;
+    if (seq_compile(&nl, r, n, g, m, s, k) != SUCCESS) {
+        return NULL;
+    }
+
+    size_t w = (runs + 63) / 64;
+    size_t slots = nl.n_slots + nl.n_scratch;
+
+    // The slots and the latched values share one block with the simulator.
+    gate_seq_t *q = malloc(sizeof(gate_seq_t) + (slots + n) * w * sizeof(uint64_t));
+    if (q == NULL) {
+        netlist_free(&nl);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    q->nl = nl;
+    q->n_in = k;
+    q->n_regs = n;
+    q->n_out = m;
+    q->w = w;
+    q->v = (uint64_t *) (q + 1);
+    q->next = q->v + slots * w;
+
+    memset(q->v, 0, slots * w * sizeof(uint64_t));
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t *state = q->v + (k + i) * w;
+        for (size_t j = 0; j < w; ++j) {
+            state[j] = r[i]->q ? ~UINT64_C(0) : 0;
+        }
+    }
+
+    return q;
+}
+
+void gate_seq_delete(gate_seq_t *q) {
+    if (q == NULL) {
+        return;
+    }
+
+    netlist_free(&q->nl);
+    free(q);
+}
+
+int gate_seq_step(gate_seq_t *q, uint64_t const *in, uint64_t *out, size_t cycles) {
+    if (q == NULL || (in == NULL && q->n_in > 0 && cycles > 0)) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    size_t w = q->w;
+    uint64_t *v = q->v;
+    uint64_t *state = v + q->n_in * w;
+    size_t const *observed = q->nl.outputs;
+    size_t const *latched = q->nl.outputs + q->n_out;
+
+    for (size_t c = 0; c < cycles; ++c) {
+        if (q->n_in > 0) {
+            memcpy(v, in + c * q->n_in * w, q->n_in * w * sizeof(uint64_t));
+        }
+
+        netlist_eval(&q->nl, v, w);
+
+        if (out != NULL) {
+            uint64_t *dst = out + c * q->n_out * w;
+            for (size_t j = 0; j < q->n_out; ++j) {
+                for (size_t k = 0; k < w; ++k) {
+                    dst[j * w + k] = v[observed[j] * w + k];
+                }
+            }
+        }
+
+        // A register may read another register directly, so all inputs are gathered before any output changes.
+        for (size_t i = 0; i < q->n_regs; ++i) {
+            for (size_t k = 0; k < w; ++k) {
+                q->next[i * w + k] = v[latched[i] * w + k];
+            }
+        }
+        memcpy(state, q->next, q->n_regs * w * sizeof(uint64_t));
+    }
+
+    return SUCCESS;
+}
+
+int gate_seq_get_state(gate_seq_t const *q, size_t i, uint64_t *bits) {
+    if (q == NULL || bits == NULL || i >= q->n_regs) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    memcpy(bits, q->v + (q->n_in + i) * q->w, q->w * sizeof(uint64_t));
+    return SUCCESS;
+}
+
+int gate_seq_set_state(gate_seq_t *q, size_t i, uint64_t const *bits) {
+    if (q == NULL || bits == NULL || i >= q->n_regs) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    memcpy(q->v + (q->n_in + i) * q->w, bits, q->w * sizeof(uint64_t));
+    return SUCCESS;
+}
@@ -0,0 +1,175 @@
+#ifndef SEQUENTIAL_H
+#define SEQUENTIAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "gate.h"
+
+typedef struct gate_reg gate_reg_t;
+typedef struct gate_seq gate_seq_t;
+
+/**
+ * @brief Creates a new register (D flip-flop).
+ *
+ * The output (Q) of a register is a signal which is connected to gates with `gate_connect_signal`,
+ * so a feedback loop through a register is not a cycle for `gate_evaluate`. The input (D) is initially
+ * unconnected.
+ *
+ * @param init The initial value of the output.
+ * @return
+ * - Pointer to the created register on success.
+ * - `NULL` if memory allocation fails (`errno` is set to `ENOMEM`).
+ */
+gate_reg_t *gate_reg_new(bool init);
+
+/**
+ * @brief Deletes the specified register.
+ *
+ * Does nothing if `r` is `NULL`. Gates connected to the output of the register must be
+ * disconnected from it first.
+ *
+ * @param r Pointer to the register to delete.
+ */
+void gate_reg_delete(gate_reg_t *r);
+
+/**
+ * @brief Connects the output of a gate to the input of a register.
+ *
+ * Any signal previously connected to the register will be disconnected. Deleting `g_out` leaves
+ * the register unconnected. The register is not counted by `gate_fan_out(g_out)`.
+ *
+ * @param g_out Pointer to the gate.
+ * @param r Pointer to the register.
+ * @return
+ * - 0 on success.
+ * - -1 if any pointer is `NULL` (`errno` is set to `EINVAL`).
+ * - -1 if memory allocation fails (`errno` is set to `ENOMEM`).
+ */
+int gate_reg_connect_gate(gate_t *g_out, gate_reg_t *r);
+
+/**
+ * @brief Connects a boolean signal to the input of a register.
+ *
+ * Any signal previously connected to the register will be disconnected. The signal may be
+ * the output of another register.
+ *
+ * @param s Pointer to the boolean signal.
+ * @param r Pointer to the register.
+ * @return
+ * - 0 on success.
+ * - -1 if any pointer is `NULL` (`errno` is set to `EINVAL`).
+ */
+int gate_reg_connect_signal(bool const *s, gate_reg_t *r);
+
+/**
+ * @brief Returns the signal holding the output of a register.
+ *
+ * The signal can be connected to gates with `gate_connect_signal`. It is updated by `gate_reg_tick`
+ * and stays valid until the register is deleted.
+ *
+ * @param r Pointer to the register.
+ * @return
+ * - Pointer to the output signal on success.
+ * - `NULL` if `r` is `NULL` (`errno` is set to `EINVAL`).
+ */
+bool const *gate_reg_output(gate_reg_t const *r);
+
+/**
+ * @brief Applies one clock edge to the specified registers.
+ *
+ * The inputs of all registers are evaluated first (gates with `gate_evaluate`), and only then all
+ * outputs are updated, so registers reading each other see the values from before the edge.
+ *
+ * @param r Array of pointers to the registers.
+ * @param n Size of the `r` array.
+ * @return
+ * - 0 on success.
+ * - -1 if any pointer is `NULL` or `n` is zero (`errno` is set to `EINVAL`).
+ * - -1 if a register input is unconnected or a connected gate cannot be evaluated (`errno` is set to `ECANCELED`).
+ * - -1 if memory allocation fails (`errno` is set to `ENOMEM`).
+ */
+int gate_reg_tick(gate_reg_t **r, size_t n);
+
+/**
+ * @brief Compiles a sequential circuit for cycle-based simulation of many independent runs.
+ *
+ * Compiles the combinational logic reachable from the `m` gates in `g` and from the inputs of the `n`
+ * registers in `r` into a precomputed evaluation order. Every run starts with the current outputs of the
+ * registers; input `i` of the circuit drives the signal `s[i]`. The circuit and the registers are not
+ * modified and may be changed or deleted once the simulator has been created.
+ *
+ * Values of all runs are packed into 64-bit words: bit `b` of word `j` of a value belongs to
+ * run `64 * j + b`, so every value takes `(runs + 63) / 64` words.
+ *
+ * @param r Array of pointers to the registers.
+ * @param n Size of the `r` array.
+ * @param g Array of pointers to the gates whose outputs are observed, or `NULL` if `m` is zero.
+ * @param m Size of the `g` array.
+ * @param s Array of pointers to the signals fed from the inputs, or `NULL` if `k` is zero.
+ * @param k Size of the `s` array.
+ * @param runs Number of independent runs simulated at once.
+ * @return
+ * - Pointer to the created simulator on success.
+ * - `NULL` if any pointer is `NULL`, `n` or `runs` is zero, `s` contains duplicates or register outputs,
+ *   or a signal used by the circuit is neither in `s` nor the output of a register in `r`
+ *   (`errno` is set to `EINVAL`).
+ * - `NULL` if the combinational logic contains a cycle or an unconnected input (`errno` is set to `ECANCELED`).
+ * - `NULL` if memory allocation fails (`errno` is set to `ENOMEM`).
+ */
+gate_seq_t *gate_seq_new(gate_reg_t **r, size_t n, gate_t **g, size_t m, bool const **s, size_t k, size_t runs);
+
+/**
+ * @brief Deletes the specified simulator.
+ *
+ * Does nothing if `q` is `NULL`.
+ *
+ * @param q Pointer to the simulator to delete.
+ */
+void gate_seq_delete(gate_seq_t *q);
+
+/**
+ * @brief Simulates the specified number of clock cycles in all runs.
+ *
+ * In every cycle the combinational logic is evaluated once for the current inputs and register outputs,
+ * the observed gates are recorded and then all registers take the values of their inputs at once.
+ *
+ * @param q Pointer to the simulator.
+ * @param in Packed values of the `k` inputs for every cycle, cycle after cycle (`cycles * k` values),
+ *           or `NULL` if `k` is zero.
+ * @param out Array to store the packed values of the `m` observed gates for every cycle, cycle after cycle
+ *            (`cycles * m` values), or `NULL` if they are not needed.
+ * @param cycles Number of cycles to simulate.
+ * @return
+ * - 0 on success.
+ * - -1 if `q` is `NULL`, or `in` is `NULL` while the circuit has inputs (`errno` is set to `EINVAL`).
+ */
+int gate_seq_step(gate_seq_t *q, uint64_t const *in, uint64_t *out, size_t cycles);
+
+/**
+ * @brief Reads the output of a register in all runs.
+ *
+ * @param q Pointer to the simulator.
+ * @param i Index of the register in the array given to `gate_seq_new`.
+ * @param bits Array to store the packed value of the register.
+ * @return
+ * - 0 on success.
+ * - -1 if any pointer is `NULL` or `i` is invalid (`errno` is set to `EINVAL`).
+ */
+int gate_seq_get_state(gate_seq_t const *q, size_t i, uint64_t *bits);
+
+/**
+ * @brief Overwrites the output of a register in all runs.
+ *
+ * @param q Pointer to the simulator.
+ * @param i Index of the register in the array given to `gate_seq_new`.
+ * @param bits Packed value of the register.
+ * @return
+ * - 0 on success.
+ * - -1 if any pointer is `NULL` or `i` is invalid (`errno` is set to `EINVAL`).
+ */
+int gate_seq_set_state(gate_seq_t *q, size_t i, uint64_t const *bits);
+
+#endif
@@ -0,0 +1,470 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "gate_internal.h"
+#include "netlist.h"
+#include "snapshot.h"
+#include "vector.h"
+
+struct gate_snapshot {
+    netlist nl; // The arrays point into the snapshot's own block
+    slot_signal *signals;
+    size_t n_signals;
+    size_t *slot_node; // Node writing each slot, NO_NODE for slots read from signals
+    ptr_map gates;     // Address of an original gate -> its node
+};
+
+typedef struct overlay_input {
+    size_t slot;
+    bool const *signal; // When not NULL, the input reads this signal instead of the slot
+} overlay_input;
+
+// A copy of a snapshot node, made by its first edit
+typedef struct overlay_node {
+    netlist_op op;
+    bool negate;
+    size_t n_in;
+    overlay_input in[];
+} overlay_node;
+
+struct gate_overlay {
+    gate_snapshot_t const *snap;
+    ptr_map edits; // Node index + 1 -> position of its copy in `nodes`
+    overlay_node **nodes;
+    size_t n_nodes;
+    size_t cap_nodes;
+    bool rewired; // Whether a gate input was reconnected, which may break the topological order
+};
+
+// Context of a single evaluation
+typedef struct eval_ctx {
+    gate_snapshot_t const *snap;
+    gate_overlay_t const *ov;
+    bool recursive; // Whether nodes are evaluated on demand instead of in the snapshot order
+    bool *value;    // Per slot
+    unsigned *path; // Per slot
+    unsigned char *state; // Per node
+} eval_ctx;
+
+static bool const tied_false = false;
+static bool const tied_true = true;
+
+gate_snapshot_t *gate_snapshot_new(gate_t **g, size_t m) {
+    if (g == NULL || m == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    for (size_t i = 0; i < m; ++i) {
+        if (g[i] == NULL) {
+            errno = EINVAL;
+            return NULL;
+        }
+    }
+
+    size_t *outputs = malloc(m * sizeof(size_t));
+    if (outputs == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    netlist_builder b;
+    signal_slots sig = {.b = &b};
+    netlist_builder_init(&b, 0, signal_slots_resolve, &sig);
+
+    for (size_t i = 0; i < m; ++i) {
+        ssize_t slot = netlist_builder_add(&b, g[i]);
+        if (slot < 0) {
+            int error = errno;
+            netlist_builder_abort(&b);
+            signal_slots_free(&sig);
+            free(outputs);
+            errno = error;
+            return NULL;
+        }
+        outputs[i] = (size_t) slot;
+    }
+
+    size_t n_nodes = b.n_nodes;
+    size_t n_srcs = b.n_srcs;
+    size_t n_slots = b.n_slots;
+
+    // The whole copy lives in one block: the header, the nodes and their inputs, and the lookup tables.
+    size_t nodes_size = n_nodes * sizeof(netlist_node);
+    size_t srcs_size = n_srcs * sizeof(size_t);
+    size_t outputs_size = m * sizeof(size_t);
+    size_t signals_size = sig.size * sizeof(slot_signal);
+    size_t slot_node_size = n_slots * sizeof(size_t);
+    size_t gates_size = ptr_map_block_size(n_nodes);
+
+    char *block = malloc(sizeof(gate_snapshot_t) + nodes_size + srcs_size + outputs_size + signals_size +
+                         slot_node_size + gates_size);
+    if (block == NULL) {
+        netlist_builder_abort(&b);
+        signal_slots_free(&sig);
+        free(outputs);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    gate_snapshot_t *snap = (gate_snapshot_t *) block;
+    char *p = block + sizeof(gate_snapshot_t);
+
+    snap->nl = (netlist){
+            .n_inputs = 0,
+            .n_slots = n_slots,
+            .n_scratch = 0,
+            .n_nodes = n_nodes,
+            .n_outputs = m,
+            .nodes = (netlist_node *) p,
+            .srcs = (size_t *) (p + nodes_size),
+            .outputs = (size_t *) (p + nodes_size + srcs_size),
+    };
+    p += nodes_size + srcs_size + outputs_size;
+    snap->signals = (slot_signal *) p;
+    snap->n_signals = sig.size;
+    p += signals_size;
+    snap->slot_node = (size_t *) p;
+    p += slot_node_size;
+    snap->gates = ptr_map_place(p, n_nodes);
+
+    memcpy(snap->nl.nodes, b.nodes, nodes_size);
+    if (srcs_size > 0) {
+        memcpy(snap->nl.srcs, b.srcs, srcs_size);
+    }
+    memcpy(snap->nl.outputs, outputs, outputs_size);
+    if (signals_size > 0) {
+        memcpy(snap->signals, sig.data, signals_size);
+    }
+
+    for (size_t i = 0; i < n_slots; ++i) {
+        snap->slot_node[i] = NO_NODE;
+    }
+    for (size_t i = 0; i < n_nodes; ++i) {
+        snap->slot_node[snap->nl.nodes[i].dst] = i;
+        ptr_map_put(&snap->gates, (uintptr_t) b.gates[i], i);
+    }
+
+    netlist_builder_abort(&b);
+    signal_slots_free(&sig);
+    free(outputs);
+
+    return snap;
+}
+
+void gate_snapshot_delete(gate_snapshot_t *snap) {
+    free(snap);
+}
+
+// Returns the copy of a node made by the overlay, or NULL if the node is not edited
+static overlay_node const *overlay_find(gate_overlay_t const *ov, size_t node) {
+    if (ov == NULL) {
+        return NULL;
+    }
+
+    ssize_t pos = ptr_map_find(&ov->edits, node + 1);
+    return pos < 0 ? NULL : ov->nodes[pos];
+}
+
+// A function that calculates the value and the critical path of node i, evaluating its inputs first
+// when the evaluation is recursive
+static int eval_node(eval_ctx *c, size_t i) {
+    if (c->state[i] == CALCULATED) {
+        return SUCCESS;
+    }
+
+    if (c->state[i] == VISITED) {
+        // We have found a cycle
+        return FAILED;
+    }
+
+    c->state[i] = VISITED;
+
+    netlist const *nl = &c->snap->nl;
+    netlist_node const *node = &nl->nodes[i];
+    overlay_node const *e = overlay_find(c->ov, i);
+
+    netlist_op op = e != NULL ? e->op : node->op;
+    size_t n = node->n_in;
+    bool res = op == OP_AND;
+    unsigned path = 0;
+
+    for (size_t j = 0; j < n; ++j) {
+        bool value;
+        unsigned value_path = 0;
+
+        if (e != NULL && e->in[j].signal != NULL) {
+            value = *e->in[j].signal;
+        } else {
+            size_t slot = e != NULL ? e->in[j].slot : nl->srcs[node->in + j];
+            size_t src = c->snap->slot_node[slot];
+            if (c->recursive && src != NO_NODE && eval_node(c, src) != SUCCESS) {
+                return FAILED;
+            }
+            value = c->value[slot];
+            value_path = c->path[slot];
+        }
+
+        switch (op) {
+            case OP_AND:
+                res &= value;
+                break;
+            case OP_OR:
+                res |= value;
+                break;
+            default:
+                res ^= value;
+                break;
+        }
+        path = max(path, value_path);
+    }
+
+    c->value[node->dst] = res != (e != NULL ? e->negate : node->negate);
+    c->path[node->dst] = n > 0 ? path + 1 : 0;
+    c->state[i] = CALCULATED;
+
+    return SUCCESS;
+}
+
+static ssize_t snapshot_evaluate(gate_snapshot_t const *snap, gate_overlay_t const *ov, bool *s) {
+    netlist const *nl = &snap->nl;
+
+    unsigned *path = malloc(nl->n_slots * sizeof(unsigned));
+    bool *value = malloc(nl->n_slots * sizeof(bool));
+    unsigned char *state = calloc(nl->n_nodes, sizeof(unsigned char));
+    if (path == NULL || value == NULL || state == NULL) {
+        free(path);
+        free(value);
+        free(state);
+        errno = ENOMEM;
+        return FAILED;
+    }
+
+    for (size_t i = 0; i < snap->n_signals; ++i) {
+        value[snap->signals[i].slot] = *snap->signals[i].signal;
+        path[snap->signals[i].slot] = 0;
+    }
+
+    // Without reconnected gate inputs the snapshot order is still topological, so a linear pass is enough.
+    eval_ctx c = {
+            .snap = snap,
+            .ov = ov,
+            .recursive = ov != NULL && ov->rewired,
+            .value = value,
+            .path = path,
+            .state = state,
+    };
+
+    int code = SUCCESS;
+    if (c.recursive) {
+        for (size_t j = 0; j < nl->n_outputs && code == SUCCESS; ++j) {
+            code = eval_node(&c, snap->slot_node[nl->outputs[j]]);
+        }
+    } else {
+        for (size_t i = 0; i < nl->n_nodes; ++i) {
+            eval_node(&c, i);
+        }
+    }
+
+    ssize_t res = 0;
+    if (code == SUCCESS) {
+        for (size_t j = 0; j < nl->n_outputs; ++j) {
+            s[j] = value[nl->outputs[j]];
+            res = max((ssize_t) path[nl->outputs[j]], res);
+        }
+    } else {
+        errno = ECANCELED;
+        res = FAILED;
+    }
+
+    free(path);
+    free(value);
+    free(state);
+
+    return res;
+}
+
+ssize_t gate_snapshot_evaluate(gate_snapshot_t const *snap, bool *s) {
+    if (snap == NULL || s == NULL) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    return snapshot_evaluate(snap, NULL, s);
+}
+
+gate_overlay_t *gate_overlay_new(gate_snapshot_t const *snap) {
+    if (snap == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    gate_overlay_t *ov = calloc(1, sizeof(gate_overlay_t));
+    if (ov == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    ov->snap = snap;
+    return ov;
+}
+
+void gate_overlay_clear(gate_overlay_t *ov) {
+    if (ov == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < ov->n_nodes; ++i) {
+        free(ov->nodes[i]);
+    }
+    free(ov->nodes);
+    ptr_map_free(&ov->edits);
+
+    ov->nodes = NULL;
+    ov->n_nodes = ov->cap_nodes = 0;
+    ov->rewired = false;
+}
+
+void gate_overlay_delete(gate_overlay_t *ov) {
+    if (ov == NULL) {
+        return;
+    }
+
+    gate_overlay_clear(ov);
+    free(ov);
+}
+
+// Finds the node of an original gate, optionally checking that it has an input k
+static ssize_t overlay_node_of(gate_overlay_t const *ov, gate_t const *g, bool check_k, unsigned k) {
+    if (ov == NULL || g == NULL) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    ssize_t node = ptr_map_find(&ov->snap->gates, (uintptr_t) g);
+    if (node < 0 || (check_k && k >= ov->snap->nl.nodes[node].n_in)) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    return node;
+}
+
+// Returns the overlay's own copy of a node, copying it from the snapshot on its first edit
+static overlay_node *overlay_edit(gate_overlay_t *ov, size_t node) {
+    ssize_t pos = ptr_map_find(&ov->edits, node + 1);
+    if (pos >= 0) {
+        return ov->nodes[pos];
+    }
+
+    if (ov->n_nodes == ov->cap_nodes) {
+        size_t cap = ov->cap_nodes == 0 ? 4 : ov->cap_nodes * 2;
+        overlay_node **nodes = realloc(ov->nodes, cap * sizeof(overlay_node *));
+        if (nodes == NULL) {
+            errno = ENOMEM;
+            return NULL;
+        }
+        ov->nodes = nodes;
+        ov->cap_nodes = cap;
+    }
+
+    netlist_node const *base = &ov->snap->nl.nodes[node];
+    overlay_node *e = malloc(sizeof(overlay_node) + base->n_in * sizeof(overlay_input));
+    if (e == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    e->op = base->op;
+    e->negate = base->negate;
+    e->n_in = base->n_in;
+    for (size_t j = 0; j < base->n_in; ++j) {
+        e->in[j] = (overlay_input){.slot = ov->snap->nl.srcs[base->in + j], .signal = NULL};
+    }
+
+    if (ptr_map_put(&ov->edits, node + 1, ov->n_nodes) != SUCCESS) {
+        free(e);
+        errno = ENOMEM;
+        return NULL;
+    }
+    ov->nodes[ov->n_nodes++] = e;
+
+    return e;
+}
+
+int gate_overlay_set_kind(gate_overlay_t *ov, gate_t const *g, gate_kind_t kind) {
+    netlist_op op;
+    bool negate;
+    if (netlist_kind_op(kind, &op, &negate) != SUCCESS) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    ssize_t node = overlay_node_of(ov, g, false, 0);
+    if (node < 0) {
+        return FAILED;
+    }
+
+    overlay_node *e = overlay_edit(ov, (size_t) node);
+    if (e == NULL) {
+        return FAILED;
+    }
+
+    e->op = op;
+    e->negate = negate;
+    return SUCCESS;
+}
+
+int gate_overlay_connect_gate(gate_overlay_t *ov, gate_t const *g_out, gate_t const *g_in, unsigned k) {
+    ssize_t src = overlay_node_of(ov, g_out, false, 0);
+    ssize_t node = src < 0 ? FAILED : overlay_node_of(ov, g_in, true, k);
+    if (node < 0) {
+        return FAILED;
+    }
+
+    overlay_node *e = overlay_edit(ov, (size_t) node);
+    if (e == NULL) {
+        return FAILED;
+    }
+
+    e->in[k] = (overlay_input){.slot = ov->snap->nl.nodes[src].dst, .signal = NULL};
+    ov->rewired = true;
+    return SUCCESS;
+}
+
+int gate_overlay_connect_signal(gate_overlay_t *ov, bool const *s, gate_t const *g, unsigned k) {
+    if (s == NULL) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    ssize_t node = overlay_node_of(ov, g, true, k);
+    if (node < 0) {
+        return FAILED;
+    }
+
+    overlay_node *e = overlay_edit(ov, (size_t) node);
+    if (e == NULL) {
+        return FAILED;
+    }
+
+    e->in[k].signal = s;
+    return SUCCESS;
+}
+
+int gate_overlay_tie(gate_overlay_t *ov, gate_t const *g, unsigned k, bool value) {
+    return gate_overlay_connect_signal(ov, value ? &tied_true : &tied_false, g, k);
+}
+
+ssize_t gate_overlay_evaluate(gate_overlay_t const *ov, bool *s) {
+    if (ov == NULL || s == NULL) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    return snapshot_evaluate(ov->snap, ov, s);
+}
@@ -0,0 +1,150 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "gate.h"
+
+typedef struct gate_snapshot gate_snapshot_t;
+typedef struct gate_overlay gate_overlay_t;
+
+/**
+ * @brief Creates a frozen copy of the circuit reachable from the specified gates.
+ *
+ * Copies the circuit reachable from the `m` gates in `g` in a single pass into a single allocation block.
+ * The snapshot keeps reading the signals connected with `gate_connect_signal`, but does not depend on the
+ * gates themselves: the original circuit may be modified or deleted afterwards. Gates of the snapshot are
+ * identified by the addresses of the original gates, which are only used as keys and never dereferenced.
+ *
+ * @param g Array of pointers to the gates whose outputs are evaluated by the snapshot (its roots).
+ * @param m Size of the `g` array.
+ * @return
+ * - Pointer to the created snapshot on success.
+ * - `NULL` if any pointer is `NULL` or `m` is zero (`errno` is set to `EINVAL`).
+ * - `NULL` if the circuit contains a cycle or an unconnected input (`errno` is set to `ECANCELED`).
+ * - `NULL` if memory allocation fails (`errno` is set to `ENOMEM`).
+ */
+gate_snapshot_t *gate_snapshot_new(gate_t **g, size_t m);
+
+/**
+ * @brief Deletes the specified snapshot.
+ *
+ * Does nothing if `snap` is `NULL`. All overlays of the snapshot must be deleted first.
+ *
+ * @param snap Pointer to the snapshot to delete.
+ */
+void gate_snapshot_delete(gate_snapshot_t *snap);
+
+/**
+ * @brief Evaluates the roots of the snapshot and calculates the critical path length.
+ *
+ * @param snap Pointer to the snapshot.
+ * @param s Array to store the output signals of the roots, in the order given to `gate_snapshot_new`.
+ * @return
+ * - Critical path length on success (also populates the `s` array).
+ * - -1 if any pointer is `NULL` or memory allocation fails (`errno` is set to `EINVAL` or `ENOMEM`).
+ */
+ssize_t gate_snapshot_evaluate(gate_snapshot_t const *snap, bool *s);
+
+/**
+ * @brief Creates an empty copy-on-write overlay of the specified snapshot.
+ *
+ * An overlay records what-if edits of the snapshot. The first edit of a gate copies only that gate;
+ * the rest of the circuit stays shared with the snapshot and with its other overlays.
+ *
+ * @param snap Pointer to the snapshot.
+ * @return
+ * - Pointer to the created overlay on success.
+ * - `NULL` if `snap` is `NULL` (`errno` is set to `EINVAL`).
+ * - `NULL` if memory allocation fails (`errno` is set to `ENOMEM`).
+ */
+gate_overlay_t *gate_overlay_new(gate_snapshot_t const *snap);
+
+/**
+ * @brief Deletes the specified overlay.
+ *
+ * Does nothing if `ov` is `NULL`.
+ *
+ * @param ov Pointer to the overlay to delete.
+ */
+void gate_overlay_delete(gate_overlay_t *ov);
+
+/**
+ * @brief Discards all edits of the specified overlay.
+ *
+ * Does nothing if `ov` is `NULL`.
+ *
+ * @param ov Pointer to the overlay.
+ */
+void gate_overlay_clear(gate_overlay_t *ov);
+
+/**
+ * @brief Changes the kind of a gate in the overlay.
+ *
+ * @param ov Pointer to the overlay.
+ * @param g Pointer to the original gate.
+ * @param kind The new kind of the gate.
+ * @return
+ * - 0 on success.
+ * - -1 if any pointer is `NULL`, `g` is not part of the snapshot or `kind` is invalid, or memory allocation
+ *   fails (`errno` is set to `EINVAL` or `ENOMEM`).
+ */
+int gate_overlay_set_kind(gate_overlay_t *ov, gate_t const *g, gate_kind_t kind);
+
+/**
+ * @brief Connects the output of one gate to the input of another gate in the overlay.
+ *
+ * @param ov Pointer to the overlay.
+ * @param g_out Pointer to the original output gate.
+ * @param g_in Pointer to the original input gate.
+ * @param k Index of the input in `g_in` to connect.
+ * @return
+ * - 0 on success.
+ * - -1 if any pointer is `NULL`, a gate is not part of the snapshot, `k` is invalid, or memory allocation
+ *   fails (`errno` is set to `EINVAL` or `ENOMEM`).
+ */
+int gate_overlay_connect_gate(gate_overlay_t *ov, gate_t const *g_out, gate_t const *g_in, unsigned k);
+
+/**
+ * @brief Connects a boolean signal to the input of a gate in the overlay.
+ *
+ * @param ov Pointer to the overlay.
+ * @param s Pointer to the boolean signal.
+ * @param g Pointer to the original gate.
+ * @param k Index of the input in `g` to connect.
+ * @return
+ * - 0 on success.
+ * - -1 if any pointer is `NULL`, `g` is not part of the snapshot, `k` is invalid, or memory allocation
+ *   fails (`errno` is set to `EINVAL` or `ENOMEM`).
+ */
+int gate_overlay_connect_signal(gate_overlay_t *ov, bool const *s, gate_t const *g, unsigned k);
+
+/**
+ * @brief Ties the input of a gate to a constant value in the overlay.
+ *
+ * @param ov Pointer to the overlay.
+ * @param g Pointer to the original gate.
+ * @param k Index of the input in `g` to tie.
+ * @param value The constant value of the input.
+ * @return
+ * - 0 on success.
+ * - -1 if any pointer is `NULL`, `g` is not part of the snapshot, `k` is invalid, or memory allocation
+ *   fails (`errno` is set to `EINVAL` or `ENOMEM`).
+ */
+int gate_overlay_tie(gate_overlay_t *ov, gate_t const *g, unsigned k, bool value);
+
+/**
+ * @brief Evaluates the roots of the snapshot with the edits of the overlay applied.
+ *
+ * @param ov Pointer to the overlay.
+ * @param s Array to store the output signals of the roots, in the order given to `gate_snapshot_new`.
+ * @return
+ * - Critical path length on success (also populates the `s` array).
+ * - -1 if any pointer is `NULL`, the edits created a cycle, or memory allocation fails
+ *   (`errno` is set to `EINVAL`, `ECANCELED`, or `ENOMEM`).
+ */
+ssize_t gate_overlay_evaluate(gate_overlay_t const *ov, bool *s);
+
+#endif
@@ -0,0 +1,462 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "gate_internal.h"
+#include "netlist.h"
+#include "timing.h"
+#include "vector.h"
+
+#define GATE_KINDS (XNOR + 1)
+
+typedef struct timing_node {
+    netlist_op op;
+    bool negate;
+    bool pending;   // Output after all scheduled events
+    bool run_start; // Output at the start of the current run
+    unsigned delay;
+    size_t slot;    // Slot holding the output
+    size_t n_in;
+    size_t ones;    // Number of inputs which are currently true
+    size_t toggles; // Output transitions in the current run
+    size_t glitches;
+    uint64_t settle;    // Time of the last output transition
+    uint64_t scheduled; // Time of the scheduled event still on the wheel (0 if none, as delays are positive)
+    size_t event;       // Index of that event in its bucket
+} timing_node;
+
+typedef struct timing_event {
+    size_t node;
+    bool value;
+} timing_event;
+
+typedef struct timing_bucket {
+    timing_event *data;
+    size_t size;
+    size_t cap;
+} timing_bucket;
+
+struct gate_timing {
+    timing_node *nodes;
+    size_t n_nodes;
+    size_t n_slots;
+    bool *value;       // Current value of every slot
+    size_t *fan_start; // Fan-out of slot i is fan_pins[fan_start[i]] to fan_pins[fan_start[i + 1] - 1]
+    size_t *fan_pins;  // Node of every input fed by a slot
+    size_t *touched;   // Nodes whose output changed in the current run
+    size_t n_touched;
+    ptr_map signals; // Signal -> slot
+    ptr_map gates;   // Address of a gate -> its node
+    timing_bucket *wheel; // Events of time t are in wheel[t & wheel_mask]
+    size_t wheel_mask;
+    size_t n_pending;
+    uint64_t now;
+    size_t events;
+};
+
+static bool node_output(timing_node const *node) {
+    bool res;
+    switch (node->op) {
+        case OP_AND:
+            res = node->ones == node->n_in;
+            break;
+        case OP_OR:
+            res = node->ones > 0;
+            break;
+        default:
+            res = node->ones & 1;
+            break;
+    }
+
+    return res != node->negate;
+}
+
+// Schedules a change of the output of a node. A node has at most one event per time: changes of several of its
+// inputs at the same time only update that event, and one that restores the current output is skipped when processed.
+static int timing_schedule(gate_timing_t *t, size_t node, bool value, uint64_t time) {
+    timing_bucket *b = &t->wheel[time & t->wheel_mask];
+    timing_node *n = &t->nodes[node];
+
+    if (n->scheduled == time) {
+        b->data[n->event].value = value;
+        return SUCCESS;
+    }
+
+    if (b->size == b->cap) {
+        size_t cap = b->cap == 0 ? 8 : b->cap * 2;
+        timing_event *data = realloc(b->data, cap * sizeof(timing_event));
+        if (data == NULL) {
+            return FAILED;
+        }
+        b->data = data;
+        b->cap = cap;
+    }
+
+    n->scheduled = time;
+    n->event = b->size;
+    b->data[b->size++] = (timing_event){.node = node, .value = value};
+    t->n_pending++;
+    return SUCCESS;
+}
+
+// Changes the value of a slot at the current time and schedules the resulting output changes of its fan-out
+static int timing_drive(gate_timing_t *t, size_t slot, bool value) {
+    if (t->value[slot] == value) {
+        return SUCCESS;
+    }
+    t->value[slot] = value;
+
+    for (size_t p = t->fan_start[slot]; p < t->fan_start[slot + 1]; ++p) {
+        size_t i = t->fan_pins[p];
+        timing_node *node = &t->nodes[i];
+
+        if (value) {
+            node->ones++;
+        } else {
+            node->ones--;
+        }
+
+        bool out = node_output(node);
+        if (out != node->pending) {
+            node->pending = out;
+            if (timing_schedule(t, i, out, t->now + node->delay) != SUCCESS) {
+                errno = ENOMEM;
+                return FAILED;
+            }
+        }
+    }
+
+    return SUCCESS;
+}
+
+// Wraps up the glitch counts of the nodes that changed in the current run
+static void timing_finish_run(gate_timing_t *t) {
+    for (size_t k = 0; k < t->n_touched; ++k) {
+        timing_node *node = &t->nodes[t->touched[k]];
+        size_t net = t->value[node->slot] != node->run_start;
+
+        node->glitches += (node->toggles - net) / 2;
+        node->toggles = 0;
+    }
+
+    t->n_touched = 0;
+}
+
+gate_timing_t *gate_timing_new(gate_t **g, size_t m, unsigned const *delay) {
+    if (g == NULL || m == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    for (size_t i = 0; i < m; ++i) {
+        if (g[i] == NULL) {
+            errno = EINVAL;
+            return NULL;
+        }
+    }
+
+    unsigned max_delay = 1;
+    for (size_t k = 0; delay != NULL && k < GATE_KINDS; ++k) {
+        if (delay[k] == 0) {
+            errno = EINVAL;
+            return NULL;
+        }
+        max_delay = max(max_delay, delay[k]);
+    }
+
+    netlist_builder b;
+    signal_slots sig = {.b = &b};
+    netlist_builder_init(&b, 0, signal_slots_resolve, &sig);
+
+    for (size_t i = 0; i < m; ++i) {
+        if (netlist_builder_add(&b, g[i]) < 0) {
+            int error = errno;
+            netlist_builder_abort(&b);
+            signal_slots_free(&sig);
+            errno = error;
+            return NULL;
+        }
+    }
+
+    size_t n_nodes = b.n_nodes;
+    size_t n_slots = b.n_slots;
+    size_t n_pins = b.n_srcs;
+    size_t wheel_size = 2;
+    while (wheel_size <= max_delay) {
+        wheel_size *= 2;
+    }
+
+    // The arrays that never change size share one block with the simulator.
+    size_t nodes_size = n_nodes * sizeof(timing_node);
+    size_t fan_start_size = (n_slots + 1) * sizeof(size_t);
+    size_t fan_pins_size = n_pins * sizeof(size_t);
+    size_t touched_size = n_nodes * sizeof(size_t);
+    size_t gates_size = ptr_map_block_size(n_nodes);
+
+    char *block = malloc(sizeof(gate_timing_t) + nodes_size + fan_start_size + fan_pins_size + touched_size +
+                         gates_size + n_slots * sizeof(bool));
+    timing_bucket *wheel = calloc(wheel_size, sizeof(timing_bucket));
+    size_t *slot_node = malloc(n_slots * sizeof(size_t));
+    if (block == NULL || wheel == NULL || slot_node == NULL) {
+        free(block);
+        free(wheel);
+        free(slot_node);
+        netlist_builder_abort(&b);
+        signal_slots_free(&sig);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    gate_timing_t *t = (gate_timing_t *) block;
+    char *p = block + sizeof(gate_timing_t);
+    t->nodes = (timing_node *) p;
+    p += nodes_size;
+    t->fan_start = (size_t *) p;
+    p += fan_start_size;
+    t->fan_pins = (size_t *) p;
+    p += fan_pins_size;
+    t->touched = (size_t *) p;
+    p += touched_size;
+    t->gates = ptr_map_place(p, n_nodes);
+    p += gates_size;
+    t->value = (bool *) p;
+
+    t->n_nodes = n_nodes;
+    t->n_slots = n_slots;
+    t->n_touched = 0;
+    t->wheel = wheel;
+    t->wheel_mask = wheel_size - 1;
+    t->n_pending = 0;
+    t->now = 0;
+    t->events = 0;
+
+    for (size_t i = 0; i < n_slots; ++i) {
+        slot_node[i] = NO_NODE;
+        t->fan_start[i] = 0;
+    }
+    t->fan_start[n_slots] = 0;
+
+    for (size_t i = 0; i < n_nodes; ++i) {
+        netlist_node const *node = &b.nodes[i];
+        slot_node[node->dst] = i;
+        ptr_map_put(&t->gates, (uintptr_t) b.gates[i], i);
+
+        t->nodes[i] = (timing_node){
+                .op = node->op,
+                .negate = node->negate,
+                .delay = delay != NULL ? delay[b.gates[i]->kind] : 1,
+                .slot = node->dst,
+                .n_in = node->n_in,
+        };
+    }
+
+    // Counting the fan-out of every slot. For gates it comes from their `out` vectors, restricted to the
+    // compiled gates, which are exactly the ones marked as CALCULATED until the builder is released.
+    for (size_t i = 0; i < n_nodes; ++i) {
+        vector_out *out = b.gates[i]->out;
+        for (size_t k = 0; k < vector_out_size(out); ++k) {
+            gate_t const *consumer = get_element_out_at_index(out, k)->pointer;
+            if (consumer->state == CALCULATED) {
+                t->fan_start[b.nodes[i].dst + 1]++;
+            }
+        }
+    }
+    for (size_t q = 0; q < n_pins; ++q) {
+        if (slot_node[b.srcs[q]] == NO_NODE) {
+            t->fan_start[b.srcs[q] + 1]++;
+        }
+    }
+    for (size_t i = 0; i < n_slots; ++i) {
+        t->fan_start[i + 1] += t->fan_start[i];
+    }
+
+    // Filling the fan-out lists, using fan_start as the insertion cursor and shifting it back afterwards
+    for (size_t i = 0; i < n_nodes; ++i) {
+        vector_out *out = b.gates[i]->out;
+        for (size_t k = 0; k < vector_out_size(out); ++k) {
+            gate_t const *consumer = get_element_out_at_index(out, k)->pointer;
+            if (consumer->state == CALCULATED) {
+                t->fan_pins[t->fan_start[b.nodes[i].dst]++] = slot_node[consumer->idx];
+            }
+        }
+    }
+    for (size_t i = 0; i < n_nodes; ++i) {
+        for (size_t q = b.nodes[i].in; q < b.nodes[i].in + b.nodes[i].n_in; ++q) {
+            if (slot_node[b.srcs[q]] == NO_NODE) {
+                t->fan_pins[t->fan_start[b.srcs[q]]++] = i;
+            }
+        }
+    }
+    for (size_t i = n_slots; i > 0; --i) {
+        t->fan_start[i] = t->fan_start[i - 1];
+    }
+    t->fan_start[0] = 0;
+
+    // Steady state for the current values of the signals
+    for (size_t k = 0; k < sig.size; ++k) {
+        t->value[sig.data[k].slot] = *sig.data[k].signal;
+    }
+    for (size_t i = 0; i < n_nodes; ++i) {
+        timing_node *node = &t->nodes[i];
+        for (size_t q = b.nodes[i].in; q < b.nodes[i].in + node->n_in; ++q) {
+            node->ones += t->value[b.srcs[q]];
+        }
+        node->pending = node_output(node);
+        t->value[node->slot] = node->pending;
+    }
+
+    // The signal map is kept, only the list of signals is released.
+    t->signals = sig.map;
+    free(sig.data);
+    free(slot_node);
+    netlist_builder_abort(&b);
+
+    return t;
+}
+
+void gate_timing_delete(gate_timing_t *t) {
+    if (t == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i <= t->wheel_mask; ++i) {
+        free(t->wheel[i].data);
+    }
+    free(t->wheel);
+    ptr_map_free(&t->signals);
+    free(t);
+}
+
+ssize_t gate_timing_run(gate_timing_t *t, gate_stimulus_t const *s, size_t n) {
+    if (t == NULL || (s == NULL && n > 0)) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (s[i].time < (i > 0 ? s[i - 1].time : t->now) || ptr_map_find(&t->signals, (uintptr_t) s[i].signal) < 0) {
+            errno = EINVAL;
+            return FAILED;
+        }
+    }
+
+    uint64_t last = n > 0 ? s[n - 1].time : t->now;
+    size_t i = 0;
+
+    while (i < n || t->n_pending > 0) {
+        uint64_t next = UINT64_MAX;
+        if (t->n_pending > 0) {
+            // All scheduled events are less than a full turn of the wheel ahead.
+            next = t->now + 1;
+            while (t->wheel[next & t->wheel_mask].size == 0) {
+                next++;
+            }
+        }
+        if (i < n && s[i].time < next) {
+            next = s[i].time;
+        }
+
+        t->now = next;
+
+        for (; i < n && s[i].time == next; ++i) {
+            size_t slot = (size_t) ptr_map_find(&t->signals, (uintptr_t) s[i].signal);
+            if (timing_drive(t, slot, s[i].value) != SUCCESS) {
+                timing_finish_run(t);
+                return FAILED;
+            }
+        }
+
+        timing_bucket *bucket = &t->wheel[next & t->wheel_mask];
+        for (size_t k = 0; k < bucket->size; ++k) {
+            timing_event ev = bucket->data[k];
+            timing_node *node = &t->nodes[ev.node];
+            node->scheduled = 0;
+            if (t->value[node->slot] == ev.value) {
+                continue;
+            }
+
+            if (node->toggles++ == 0) {
+                node->run_start = !ev.value;
+                t->touched[t->n_touched++] = ev.node;
+            }
+            node->settle = next;
+            last = max(last, next);
+            t->events++;
+
+            if (timing_drive(t, node->slot, ev.value) != SUCCESS) {
+                // Dropping the rest of this time step, which keeps the pending count consistent
+                for (size_t j = k + 1; j < bucket->size; ++j) {
+                    t->nodes[bucket->data[j].node].scheduled = 0;
+                }
+                t->n_pending -= bucket->size;
+                bucket->size = 0;
+                timing_finish_run(t);
+                return FAILED;
+            }
+        }
+        t->n_pending -= bucket->size;
+        bucket->size = 0;
+    }
+
+    timing_finish_run(t);
+    // Nothing is pending any more, so the next run may start at the returned time even if the last time step
+    // only held events that were skipped.
+    t->now = last;
+
+    return (ssize_t) last;
+}
+
+// Finds the node of a gate, or returns NULL and sets `errno`
+static timing_node const *timing_find(gate_timing_t const *t, gate_t const *g) {
+    if (t == NULL || g == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    ssize_t i = ptr_map_find(&t->gates, (uintptr_t) g);
+    if (i < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return &t->nodes[i];
+}
+
+int gate_timing_value(gate_timing_t const *t, gate_t const *g) {
+    timing_node const *node = timing_find(t, g);
+    if (node == NULL) {
+        return FAILED;
+    }
+
+    return t->value[node->slot];
+}
+
+ssize_t gate_timing_settle_time(gate_timing_t const *t, gate_t const *g) {
+    timing_node const *node = timing_find(t, g);
+    if (node == NULL) {
+        return FAILED;
+    }
+
+    return (ssize_t) node->settle;
+}
+
+ssize_t gate_timing_glitches(gate_timing_t const *t, gate_t const *g) {
+    timing_node const *node = timing_find(t, g);
+    if (node == NULL) {
+        return FAILED;
+    }
+
+    return (ssize_t) node->glitches;
+}
+
+ssize_t gate_timing_events(gate_timing_t const *t) {
+    if (t == NULL) {
+        errno = EINVAL;
+        return FAILED;
+    }
+
+    return (ssize_t) t->events;
+}
@@ -0,0 +1,113 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "gate.h"
+
+typedef struct gate_timing gate_timing_t;
+
+/**
+ * A timestamped transition of a signal
+ */
+typedef struct gate_stimulus_t {
+    bool const *signal; // Signal connected to the circuit with `gate_connect_signal`
+    bool value;         // New value of the signal
+    uint64_t time;      // Time of the transition
+} gate_stimulus_t;
+
+/**
+ * @brief Creates an event-driven timing simulator of the circuit reachable from the specified gates.
+ *
+ * The output of a gate of kind `k` follows a change of its inputs after `delay[k]` time units (transport delay).
+ * The simulator starts at time 0 in the steady state given by the current values of the signals, and afterwards
+ * it keeps its own copy of the signal values, changed only by the stimuli passed to `gate_timing_run`.
+ * Gate outputs are propagated along the fan-out of the gates (see `gate_output`), as it was at the moment
+ * the simulator was created; the circuit may be modified or deleted afterwards.
+ *
+ * @param g Array of pointers to the gates whose fan-in cones are simulated.
+ * @param m Size of the `g` array.
+ * @param delay Array of positive delays indexed by gate kind (`NAND` to `XNOR`), or `NULL` for unit delays.
+ * @return
+ * - Pointer to the created simulator on success.
+ * - `NULL` if any pointer is `NULL`, `m` is zero or a delay is zero (`errno` is set to `EINVAL`).
+ * - `NULL` if the circuit contains a cycle or an unconnected input (`errno` is set to `ECANCELED`).
+ * - `NULL` if memory allocation fails (`errno` is set to `ENOMEM`).
+ */
+gate_timing_t *gate_timing_new(gate_t **g, size_t m, unsigned const *delay);
+
+/**
+ * @brief Deletes the specified simulator.
+ *
+ * Does nothing if `t` is `NULL`.
+ *
+ * @param t Pointer to the simulator to delete.
+ */
+void gate_timing_delete(gate_timing_t *t);
+
+/**
+ * @brief Applies signal transitions and simulates the circuit until it settles.
+ *
+ * Processes the stimuli in `s` and all gate output changes they cause, in time order, until no further change is
+ * scheduled. For every gate, the output transitions of the run that do not contribute to the final change of its
+ * output are counted as glitches: a pulse (two transitions) is one glitch.
+ *
+ * @param t Pointer to the simulator.
+ * @param s Array of stimuli, sorted by time, not earlier than the time the previous run ended.
+ * @param n Size of the `s` array.
+ * @return
+ * - The time of the last gate output transition of the run, or the time of the last stimulus if no gate output
+ *   changed, on success.
+ * - -1 if any pointer is `NULL`, the stimuli are not sorted or too early, or a signal is not connected to
+ *   the circuit (`errno` is set to `EINVAL`).
+ * - -1 if memory allocation fails (`errno` is set to `ENOMEM`).
+ */
+ssize_t gate_timing_run(gate_timing_t *t, gate_stimulus_t const *s, size_t n);
+
+/**
+ * @brief Returns the current output of a gate in the simulation.
+ *
+ * @param t Pointer to the simulator.
+ * @param g Pointer to the gate.
+ * @return
+ * - The output of the gate (0 or 1) on success.
+ * - -1 if any pointer is `NULL` or `g` is not simulated (`errno` is set to `EINVAL`).
+ */
+int gate_timing_value(gate_timing_t const *t, gate_t const *g);
+
+/**
+ * @brief Returns the time at which the output of a gate last changed.
+ *
+ * @param t Pointer to the simulator.
+ * @param g Pointer to the gate.
+ * @return
+ * - The time of the last output transition of the gate (0 if it never changed) on success.
+ * - -1 if any pointer is `NULL` or `g` is not simulated (`errno` is set to `EINVAL`).
+ */
+ssize_t gate_timing_settle_time(gate_timing_t const *t, gate_t const *g);
+
+/**
+ * @brief Returns the number of glitches of a gate counted by all runs.
+ *
+ * @param t Pointer to the simulator.
+ * @param g Pointer to the gate.
+ * @return
+ * - The number of glitches on success.
+ * - -1 if any pointer is `NULL` or `g` is not simulated (`errno` is set to `EINVAL`).
+ */
+ssize_t gate_timing_glitches(gate_timing_t const *t, gate_t const *g);
+
+/**
+ * @brief Returns the number of gate output events processed by all runs.
+ *
+ * @param t Pointer to the simulator.
+ * @return
+ * - The number of processed events on success.
+ * - -1 if `t` is `NULL` (`errno` is set to `EINVAL`).
+ */
+ssize_t gate_timing_events(gate_timing_t const *t);
+
+#endif
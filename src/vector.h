@@ -27,7 +27,10 @@ typedef struct el_in element_in;
 struct el_in {
     in_connection_type_t connection_type;
     void *pointer; //  Under this pointer, there may be either a gate or a signal.
-    element_out *origin; // A pointer to an element located in the pointer->out array (when the element is a gate).
+    union {
+        element_out *origin; // A pointer to an element located in the pointer->out array (when the element is a gate).
+        size_t port; // Position in the pointer->ports list (when the element is a port bound to a gate).
+    };
 };
 typedef struct vec_in vector_in;
 struct vec_in {